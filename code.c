@@ -0,0 +1,93 @@
+// Table of long constraint length r=1/2 convolutional codes
+// Copyright 2004-2014, Phil Karn, KA9Q
+// May be used under the terms of the GNU Lesser General Public License (LGPL)
+
+#include <stdlib.h>
+#include <strings.h>
+#include "code.h"
+
+const struct conv_code Conv_codes[] = {
+  // MCQLI-24
+  // k=24 r=1/2 Massey QLI code for ISEE-3/International Comet Explorer
+  // The ref gives the polynomials as 073353367 and 053353367 (octal)
+  // Shortened from MCQLI-48
+  // The second symbol is inverted
+  {"MCQLI24",   073665667, 073665665, 24, 0, 1},
+
+  //"NASA standard" code by Massey & Costello
+  // Shortened from MCQLI-48:
+  // Nonsystematic, quick look-in, dmin=11, dfree=23
+  // used on Pioneer 10-12, Helios A,B
+  {"MCQLI32",   0xbbef6bb7, 0xbbef6bb5, 32, 0, 0},
+
+  // Massey-Johannesson code
+  // Nonsystematic, quick look-in, dmin=13, dfree>=23
+  // Purported to be more computationally efficient than Massey-Costello
+  // Appears related to  1JQLIODP-24
+  {"MJ",        0xb840a20f, 0xb840a20d, 32, 0, 0},
+
+  // Layland-Lushbaugh code
+  // Nonsystematic, non-quick look-in, dmin=?, dfree=?
+  {"LL",        0xf2d05351, 0xe4613c47, 32, 0, 0},
+
+  // 1JQLIODP-24
+  // Johannassen QLI ODP k=24
+  {"RJ1",       074121017, 074121015, 24, 0, 0},
+
+  // 2JQLIODP-24
+  // Johannassen QLI ODP k=24
+  {"RJ2",       073541017, 073541015, 24, 0, 0},
+
+  // BJ-24
+  // Bahl-Jelinek k=24 complementary code
+  {"BJ24",      054220245, 063557533, 24, 0, 0},
+
+  // QR-24 code
+  // Massey, Costello, Justesen Quadratic k=24 residue code
+  {"QR24",      026241177, 037620515, 24, 0, 0},
+
+  // OT-24
+  // Massey k=24 optimally truncatable code
+  {"OT24",      062650457, 062650455, 24, 0, 0},
+
+  // JP-24
+  // Mentioned in addendum to Massey
+  // Non-QLI, non-systematic
+  {"JP24",      052431655, 061411757, 24, 0, 0},
+
+  // MCQLI-48
+  // Massey-Costelli QLI code k=48
+  {"MCQLI48",   06556767373665667LL, 06556767373665665LL, 48, 0, 0},
+
+  // JQLIODP-48
+  // Johannesson QLI ODP code with k=48
+  {"JQLIODP48", 05634247020121017LL, 05634247020121015LL, 48, 0, 0},
+
+  // BLLF-47
+  // Bussgang, Lin, Lynn, Forney k=47
+  // Systematic. The generator given is only 45 bits long
+  {"BLLF47",    1, 0531746407671547LL, 45, 0, 0},
+
+  // JSODP-47
+  // Johannesson's ODP k=47
+  // Systematic
+  {"JSODP47",   1, 03331355751514473LL, 47, 0, 0},
+
+  // Monster k=60 Johannesson systematic
+  {"J60",       1, 073607331355751514473LL, 60, 0, 0},
+
+  // Monster k=50 Johannesson QLI
+  {"J50",       075634247020121017LL, 075634247020121015LL, 50, 0, 0},
+
+  {NULL},
+};
+
+// Look up a code by name
+const struct conv_code *find_conv_code(const char *name){
+  const struct conv_code *code;
+
+  for(code = Conv_codes; code->name != NULL; code++)
+    if(strcasecmp(code->name,name) == 0)
+      return code;
+  return NULL;
+}
@@ -2,6 +2,8 @@
  * Copyright 2004 Phil Karn, KA9Q
  */
 #include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
 #include "fec.h"
 #ifdef __VEC__
 #include <sys/sysctl.h>
@@ -11,11 +13,17 @@
 char *Cpu_modes[] = {"Unknown","Portable C","x86 Multi Media Extensions (MMX)",
 		   "x86 Streaming SIMD Extensions (SSE)",
 		   "x86 Streaming SIMD Extensions 2 (SSE2)",
-		   "PowerPC G4/G5 Altivec/Velocity Engine"};
+		   "PowerPC G4/G5 Altivec/Velocity Engine",
+		   "x86 Advanced Vector Extensions 2 (AVX2)",
+		   "x86 Supplemental Streaming SIMD Extensions 3 (SSSE3)",
+		   "x86 Streaming SIMD Extensions 4.1 (SSE4.1)",
+		   "x86 AVX-512 Byte and Word Instructions (AVX-512BW)"};
 
 enum cpu_mode Cpu_mode;
+unsigned int Cpu_features;
 
 void find_cpu_mode(void){
+  char *cap;
 
   if(Cpu_mode != UNKNOWN)
     return;
@@ -28,13 +36,17 @@ void find_cpu_mode(void){
   size_t length = sizeof(hasVectorUnit);
   int error = sysctl(selectors, 2, &hasVectorUnit, &length, NULL, 0);
   if(0 == error && hasVectorUnit)
-    Cpu_mode = ALTIVEC;
-  else
-    Cpu_mode = PORT;
+    Cpu_features |= CPU_ALTIVEC;
   }
-#else
-  Cpu_mode = PORT;
 #endif
+  /* FEC_CPU_MODE=port turns off Altivec, e.g. for benchmarking */
+  if((cap = getenv("FEC_CPU_MODE")) != NULL){
+    if(strcasecmp(cap,"port") == 0)
+      Cpu_features = 0;
+    else if(strcasecmp(cap,"altivec") != 0)
+      fprintf(stderr,"FEC_CPU_MODE=%s not recognized, ignored\n",cap);
+  }
+  Cpu_mode = (Cpu_features & CPU_ALTIVEC) ? ALTIVEC : PORT;
 
   fprintf(stderr,"SIMD CPU detect: %s\n",Cpu_modes[Cpu_mode]);
 }
@@ -2,34 +2,106 @@
  * Copyright 2004 Phil Karn, KA9Q
  */
 #include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <cpuid.h>
 #include "fec.h"
 
 /* Various SIMD instruction set names */
 char *Cpu_modes[] = {"Unknown","Portable C","x86 Multi Media Extensions (MMX)",
 		   "x86 Streaming SIMD Extensions (SSE)",
 		   "x86 Streaming SIMD Extensions 2 (SSE2)",
-		   "PowerPC G4/G5 Altivec/Velocity Engine"};
+		   "PowerPC G4/G5 Altivec/Velocity Engine",
+		   "x86 Advanced Vector Extensions 2 (AVX2)",
+		   "x86 Supplemental Streaming SIMD Extensions 3 (SSSE3)",
+		   "x86 Streaming SIMD Extensions 4.1 (SSE4.1)",
+		   "x86 AVX-512 Byte and Word Instructions (AVX-512BW)"};
 
 enum cpu_mode Cpu_mode;
+unsigned int Cpu_features;
+
+/* Selectable levels, lowest first. FEC_CPU_MODE names one of these */
+static struct {
+  char *name;
+  enum cpu_mode mode;
+  unsigned int feature;
+} Levels[] = {
+  {"port",     PORT,     0},
+  {"mmx",      MMX,      CPU_MMX},
+  {"sse",      SSE,      CPU_SSE},
+  {"sse2",     SSE2,     CPU_SSE2},
+  {"ssse3",    SSSE3,    CPU_SSSE3},
+  {"sse4.1",   SSE41,    CPU_SSE41},
+  {"avx2",     AVX2,     CPU_AVX2},
+  {"avx512bw", AVX512BW, CPU_AVX512BW},
+};
+#define NLEVELS (sizeof(Levels)/sizeof(Levels[0]))
+
+/* Ask CPUID which SIMD extensions exist. AVX2 and AVX-512 need more
+ * than the CPUID bit: the OS must also save and restore the wider
+ * registers on a context switch, which XGETBV tells us
+ */
+static unsigned int x86_features(void){
+  unsigned int eax,ebx,ecx,edx,xcr0 = 0,xcr0_hi,max,f = 0;
+
+  if((max = __get_cpuid_max(0,NULL)) < 1) /* No CPUID at all */
+    return 0;
+  __cpuid(1,eax,ebx,ecx,edx);
+  if(edx & (1<<23))
+    f |= CPU_MMX;
+  if(edx & (1<<25))
+    f |= CPU_SSE;
+  if(edx & (1<<26))
+    f |= CPU_SSE2;
+  if(ecx & (1<<1))
+    f |= CPU_PCLMUL;
+  if(ecx & (1<<9))
+    f |= CPU_SSSE3;
+  if(ecx & (1<<19))
+    f |= CPU_SSE41;
+  if(ecx & (1<<27)) /* OSXSAVE: XGETBV is usable */
+    __asm__ __volatile__ ("xgetbv" : "=a"(xcr0),"=d"(xcr0_hi) : "c"(0));
+
+  /* AVX2 needs XMM and YMM state, AVX-512 also the opmask and ZMM state */
+  if(max >= 7 && (ecx & (1<<28)) && (xcr0 & 0x06) == 0x06){
+    __cpuid_count(7,0,eax,ebx,ecx,edx);
+    if(ebx & (1<<5))
+      f |= CPU_AVX2;
+    if((xcr0 & 0xe6) == 0xe6 && (ebx & (1<<16)) && (ebx & (1<<30))) /* AVX512F and AVX512BW */
+      f |= CPU_AVX512BW;
+  }
+  return f;
+}
 
 void find_cpu_mode(void){
+  char *cap;
+  int i,top;
 
   if(Cpu_mode != UNKNOWN)
     return;
 
-  {
-  int f;
-  /* Figure out what kind of CPU we have */
-  f = cpu_features();
-  if(f & (1<<26)){ /* SSE2 is present */
-    Cpu_mode = SSE2;
-  } else if(f & (1<<25)){ /* SSE is present */
-    Cpu_mode = SSE;
-  } else if(f & (1<<23)){ /* MMX is present */
-    Cpu_mode = MMX;
-  } else { /* No SIMD at all */
-    Cpu_mode = PORT;
-  }
+  Cpu_features = x86_features();
+
+  /* Optional cap, e.g. for benchmarking a lower level on a newer CPU */
+  top = NLEVELS-1;
+  if((cap = getenv("FEC_CPU_MODE")) != NULL){
+    for(i=0;i<NLEVELS;i++)
+      if(strcasecmp(cap,Levels[i].name) == 0)
+	break;
+    if(i == NLEVELS)
+      fprintf(stderr,"FEC_CPU_MODE=%s not recognized, ignored\n",cap);
+    else
+      top = i;
   }
+  for(i=NLEVELS-1;i>top;i--)
+    Cpu_features &= ~Levels[i].feature;
+  if(!(Cpu_features & (CPU_SSE41|CPU_AVX2|CPU_AVX512BW)))
+    Cpu_features &= ~CPU_PCLMUL;
+
+  /* Take the highest level that's left */
+  for(i=top;i>0;i--)
+    if(Cpu_features & Levels[i].feature)
+      break;
+  Cpu_mode = Levels[i].mode;
   fprintf(stderr,"SIMD CPU detect: %s\n",Cpu_modes[Cpu_mode]);
 }
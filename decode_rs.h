@@ -14,10 +14,18 @@
  *            elements in index (log) form to polynomial form. Read only.
  * INDEX_OF - The address of an array of NN elements to convert Galois field
  *            elements in polynomial form to index (log) form. Read only.
+ * ALPHA_TO2 - Optional. The address of an array of 2*NN elements repeating ALPHA_TO,
+ *             so the sum of two logs can index it without MODNN. Read only.
  * MODNN - a function to reduce its argument modulo NN. May be inline or a macro.
  * FCR - An integer literal or variable specifying the first consecutive root of the
  *       Reed-Solomon generator polynomial. Integer variable or literal.
  * PRIM - The primitive root of the generator poly. Integer variable or literal.
+ * SYNDROME - Optional. SYNDROME(s,data,len) evaluates the len symbols of data[] at
+ *            every root into s[], in polynomial form, in place of the generic loop
+ * CORRECTION - Optional. CORRECTION(x) maps an error value to the representation
+ *              of data[], which must be a linear map, e.g., to the CCSDS dual basis
+ * STRIDE - Optional. Spacing of the symbols in data[], e.g., the depth of an
+ *          interleaved frame. Default 1
  * DEBUG - If set to 1 or more, do various internal consistency checking. Leave this
  *         undefined for production code
 
@@ -63,10 +71,27 @@
 #define NULL ((void *)0)
 #endif
 
+#if !defined(CORRECTION)
+#define CORRECTION(x) (x)
+#endif
+
+#if !defined(STRIDE)
+#define STRIDE 1
+#endif
+
 #undef MIN
 #define	MIN(a,b)	((a) < (b) ? (a) : (b))
 #undef A0
 #define A0 (NN)
+#undef EXP2
+#if defined(ALPHA_TO2)
+#define EXP2(x) ALPHA_TO2[x]
+#else
+#define EXP2(x) ALPHA_TO[MODNN(x)]
+#endif
+/* MODNN for 0 <= x < 2*NN, without the loop */
+#undef MOD2NN
+#define MOD2NN(x) ((x) >= NN ? (x) - NN : (x))
 
 {
   int deg_lambda, el, deg_omega;
@@ -79,18 +104,22 @@
   int syn_error, count;
 
   /* form the syndromes; i.e., evaluate data(x) at roots of g(x) */
+#if defined(SYNDROME)
+  SYNDROME(s,data,NN-PAD);
+#else
   for(i=0;i<NROOTS;i++)
     s[i] = data[0];
 
   for(j=1;j<NN-PAD;j++){
     for(i=0;i<NROOTS;i++){
       if(s[i] == 0){
-	s[i] = data[j];
+	s[i] = data[j*STRIDE];
       } else {
-	s[i] = data[j] ^ ALPHA_TO[MODNN(INDEX_OF[s[i]] + (FCR+i)*PRIM)];
+	s[i] = data[j*STRIDE] ^ ALPHA_TO[MODNN(INDEX_OF[s[i]] + (FCR+i)*PRIM)];
       }
     }
   }
+#endif
 
   /* Convert syndromes to index form, checking for nonzero condition */
   syn_error = 0;
@@ -117,7 +146,7 @@
       for (j = i+1; j > 0; j--) {
 	tmp = INDEX_OF[lambda[j - 1]];
 	if(tmp != A0)
-	  lambda[j] ^= ALPHA_TO[MODNN(u + tmp)];
+	  lambda[j] ^= EXP2(u + tmp);
       }
     }
 
@@ -171,7 +200,7 @@
     discr_r = 0;
     for (i = 0; i < r; i++){
       if ((lambda[i] != 0) && (s[r-i-1] != A0)) {
-	discr_r ^= ALPHA_TO[MODNN(INDEX_OF[lambda[i]] + s[r-i-1])];
+	discr_r ^= EXP2(INDEX_OF[lambda[i]] + s[r-i-1]);
       }
     }
     discr_r = INDEX_OF[discr_r];	/* Index form */
@@ -184,7 +213,7 @@
       t[0] = lambda[0];
       for (i = 0 ; i < NROOTS; i++) {
 	if(b[i] != A0)
-	  t[i+1] = lambda[i+1] ^ ALPHA_TO[MODNN(discr_r + b[i])];
+	  t[i+1] = lambda[i+1] ^ EXP2(discr_r + b[i]);
 	else
 	  t[i+1] = lambda[i+1];
       }
@@ -195,7 +224,7 @@
 	 * lambda(x)
 	 */
 	for (i = 0; i <= NROOTS; i++)
-	  b[i] = (lambda[i] == 0) ? A0 : MODNN(INDEX_OF[lambda[i]] - discr_r + NN);
+	  b[i] = (lambda[i] == 0) ? A0 : MOD2NN(INDEX_OF[lambda[i]] - discr_r + NN);
       } else {
 	/* 2 lines below: B(x) <-- x*B(x) */
 	memmove(&b[1],b,NROOTS*sizeof(b[0]));
@@ -215,11 +244,11 @@
   /* Find roots of the error+erasure locator polynomial by Chien search */
   memcpy(&reg[1],&lambda[1],NROOTS*sizeof(reg[0]));
   count = 0;		/* Number of roots of lambda(x) */
-  for (i = 1,k=IPRIM-1; i <= NN; i++,k = MODNN(k+IPRIM)) {
+  for (i = 1,k=IPRIM-1; i <= NN; i++,k = MOD2NN(k+IPRIM)) {
     q = 1; /* lambda[0] is always 0 */
     for (j = deg_lambda; j > 0; j--){
       if (reg[j] != A0) {
-	reg[j] = MODNN(reg[j] + j);
+	reg[j] = MOD2NN(reg[j] + j);
 	q ^= ALPHA_TO[reg[j]];
       }
     }
@@ -254,7 +283,7 @@
     tmp = 0;
     for(j=i;j >= 0; j--){
       if ((s[i - j] != A0) && (lambda[j] != A0))
-	tmp ^= ALPHA_TO[MODNN(s[i - j] + lambda[j])];
+	tmp ^= EXP2(s[i - j] + lambda[j]);
     }
     omega[i] = INDEX_OF[tmp];
   }
@@ -286,7 +315,7 @@
 #endif
     /* Apply error to data */
     if (num1 != 0 && loc[j] >= PAD) {
-      data[loc[j]-PAD] ^= ALPHA_TO[MODNN(INDEX_OF[num1] + INDEX_OF[num2] + NN - INDEX_OF[den])];
+      data[(loc[j]-PAD)*STRIDE] ^= CORRECTION(ALPHA_TO[MODNN(INDEX_OF[num1] + INDEX_OF[num2] + NN - INDEX_OF[den])]);
     }
   }
  finish:
@@ -7,9 +7,57 @@
 #include <stdio.h>
 #endif
 
+#include <stdlib.h>
 #include <string.h>
 
+#include "fec.h"
 #include "fixed.h"
+#include "rs_syndrome.h"
+
+/* Syndrome tables and dual basis nibble tables, built on first use */
+static void *Syndrome_8;
+static unsigned char *Dual_conv;
+
+/* Syndrome tables for this code, also used by the interleaved decoders; NULL if out of memory */
+void *syndrome_rs_8(void){
+  void *sp,*expected = NULL;
+
+  if((sp = __atomic_load_n(&Syndrome_8,__ATOMIC_ACQUIRE)) != NULL)
+    return sp;
+  if((sp = init_rs_syndrome(MM,ALPHA_TO,INDEX_OF,FCR,PRIM,NROOTS)) == NULL)
+    return NULL;
+  /* Another thread may have beaten us to it */
+  if(!__atomic_compare_exchange_n(&Syndrome_8,&expected,sp,0,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE)){
+    free_rs_syndrome(sp);
+    sp = expected;
+  }
+  return sp;
+}
+
+/* Nibble tables for rs_syndrome_il() of the map from the CCSDS dual basis
+ * to the conventional one, which is linear; NULL if out of memory
+ */
+const unsigned char *dual_conv_rs_8(void){
+  unsigned char *cp,*expected = NULL;
+  int j;
+
+  if((cp = __atomic_load_n(&Dual_conv,__ATOMIC_ACQUIRE)) != NULL)
+    return cp;
+  if((cp = malloc(32)) == NULL)
+    return NULL;
+  for(j=0;j<16;j++){
+    cp[j] = Tal1tab[j];
+    cp[16+j] = Tal1tab[j << 4];
+  }
+  /* Another thread may have beaten us to it */
+  if(!__atomic_compare_exchange_n(&Dual_conv,&expected,cp,0,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE)){
+    free(cp);
+    cp = expected;
+  }
+  return cp;
+}
+
+#define SYNDROME(s,data,len) rs_syndrome(Syndrome_8,s,data,len)
 
 int decode_rs_8(data_t *data, int *eras_pos, int no_eras, int pad){
   int retval;
@@ -17,6 +65,8 @@ int decode_rs_8(data_t *data, int *eras_pos, int no_eras, int pad){
   if(pad < 0 || pad > 222){
     return -1;
   }
+  if(syndrome_rs_8() == NULL)
+    return -1;
 
 #include "decode_rs.h"
   
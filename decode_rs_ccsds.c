@@ -1,26 +1,32 @@
-/* This function wraps around the fixed 8-bit decoder, performing the
- * basis transformations necessary to meet the CCSDS standard
+/* Reed-Solomon decoder for the CCSDS (255,223) code with dual-basis symbols
  *
  * Copyright 2002, Phil Karn, KA9Q
  * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ *
+ * The basis change is linear, so rather than convert the whole block to the
+ * conventional basis and back, the syndrome evaluator applies it on the fly
+ * and the error values are converted to the dual basis before they're added
+ * in. The block is only read, except at the symbols that get corrected.
  */
-#include "ccsds.h"
+#include <string.h>
 #include "fec.h"
+#include "fixed.h"
+#include "rs_syndrome.h"
+
+#define SYNDROME(s,data,len) rs_syndrome_il(sp,s,data,len,1,conv)
+#define CORRECTION(x) Taltab[x]
 
 int decode_rs_ccsds(data_t *data,int *eras_pos,int no_eras,int pad){
-  int i,r;
-  data_t cdata[NN];
+  int retval;
+  const unsigned char *conv;
+  void *sp;
 
-  /* Convert data from dual basis to conventional */
-  for(i=0;i<NN-pad;i++)
-    cdata[i] = Tal1tab[data[i]];
+  if(pad < 0 || pad > 222)
+    return -1;
+  if((sp = syndrome_rs_8()) == NULL || (conv = dual_conv_rs_8()) == NULL)
+    return -1;
 
-  r = decode_rs_8(cdata,eras_pos,no_eras,pad);
+#include "decode_rs.h"
 
-  if(r > 0){
-    /* Convert from conventional to dual basis */
-    for(i=0;i<NN-pad;i++)
-      data[i] = Taltab[cdata[i]];
-  }
-  return r;
+  return retval;
 }
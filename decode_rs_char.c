@@ -11,6 +11,9 @@
 
 #include "char.h"
 #include "rs-common.h"
+#include "rs_syndrome.h"
+
+#define SYNDROME(s,data,len) rs_syndrome(rs->synd,s,data,len)
 
 int decode_rs_char(void *p, data_t *data, int *eras_pos, int no_eras){
   int retval;
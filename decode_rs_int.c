@@ -11,6 +11,54 @@
 
 #include "int.h"
 #include "rs-common.h"
+#include "rs_syndrome.h"
+
+#define SYNDROME(s,data,len) syndrome_int(rs,s,data,len)
+
+/* Evaluate data at every root with the field arithmetic init_rs_int() picked */
+static void syndrome_int(struct rs *rs,data_t *s,const data_t *data,int len){
+  data_t roots[NROOTS];
+  int i,j;
+
+  switch(rs->field){
+  case RS_FIELD_TABLE:
+    {
+      const unsigned char *row[NROOTS];
+
+      /* Row i multiplies by root i */
+      for(i=0;i<NROOTS;i++){
+	row[i] = rs->mul + (ALPHA_TO[MODNN((FCR+i)*PRIM)] << MM);
+	s[i] = data[0];
+      }
+      for(j=1;j<len;j++)
+	for(i=0;i<NROOTS;i++)
+	  s[i] = row[i][s[i]] ^ data[j];
+    }
+    break;
+#if defined(__i386__) || defined(__x86_64__)
+  case RS_FIELD_CLMUL:
+    for(i=0;i<NROOTS;i++)
+      roots[i] = ALPHA_TO[MODNN((FCR+i)*PRIM)];
+    rs_syndrome_clmul(s,data,len,roots,NROOTS,MM,rs->gfpoly);
+    break;
+#endif
+  default:
+    /* Roots in index form */
+    for(i=0;i<NROOTS;i++){
+      roots[i] = MODNN((FCR+i)*PRIM);
+      s[i] = data[0];
+    }
+    for(j=1;j<len;j++){
+      for(i=0;i<NROOTS;i++){
+	if(s[i] == 0)
+	  s[i] = data[j];
+	else
+	  s[i] = data[j] ^ ALPHA_TO2[INDEX_OF[s[i]] + roots[i]];
+      }
+    }
+    break;
+  }
+}
 
 int decode_rs_int(void *p, data_t *data, int *eras_pos, int no_eras){
   int retval;
@@ -12,10 +12,13 @@ void freedp_port(void *p);
 
 #ifdef __i386__
 void *initdp_mmx(signed short coeffs[],int len);
-void *initdp_sse2(signed short coeffs[],int len);
 long dotprod_mmx(void *p,signed short *b);
-long dotprod_sse2(void *p,signed short *b);
 void freedp_mmx(void *p);
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
+void *initdp_sse2(signed short coeffs[],int len);
+long dotprod_sse2(void *p,signed short *b);
 void freedp_sse2(void *p);
 #endif
 
@@ -37,7 +40,13 @@ void *initdp(signed short coeffs[],int len){
   case MMX:
   case SSE:
     return initdp_mmx(coeffs,len);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
   case SSE2:
+  case SSSE3:
+  case SSE41:
+  case AVX2:
+  case AVX512BW:
     return initdp_sse2(coeffs,len);
 #endif
 
@@ -58,7 +67,13 @@ void freedp(void *p){
   case MMX:
   case SSE:
     return freedp_mmx(p);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
   case SSE2:
+  case SSSE3:
+  case SSE41:
+  case AVX2:
+  case AVX512BW:
     return freedp_sse2(p);
 #endif
 #ifdef __VEC__
@@ -80,7 +95,13 @@ long dotprod(void *p,signed short a[]){
   case MMX:
   case SSE:
     return dotprod_mmx(p,a);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
   case SSE2:
+  case SSSE3:
+  case SSE41:
+  case AVX2:
+  case AVX512BW:
     return dotprod_sse2(p,a);
 #endif
 
@@ -18,7 +18,27 @@ struct dotprod {
   signed short *coeffs[8];
 };
 
+#ifdef __x86_64__
+#include <emmintrin.h>
+
+/* dotprod_sse2_assist.s is 32-bit code, so do the same thing with intrinsics.
+ * a and b must be 128-bit aligned; cnt is the number of 8-word blocks
+ */
+static long dotprod_sse2_assist(signed short *a,signed short *b,int cnt){
+  __m128i *ap = (__m128i *)a;
+  __m128i *bp = (__m128i *)b;
+  __m128i sum = _mm_setzero_si128();
+
+  while(cnt-- != 0)
+    sum = _mm_add_epi32(sum,_mm_madd_epi16(*ap++,*bp++));
+
+  sum = _mm_add_epi32(sum,_mm_srli_si128(sum,8));
+  sum = _mm_add_epi32(sum,_mm_srli_si128(sum,4));
+  return _mm_cvtsi128_si32(sum);
+}
+#else
 long dotprod_sse2_assist(signed short *a,signed short *b,int cnt);
+#endif
 
 /* Create and return a descriptor for use with the dot product function */
 void *initdp_sse2(signed short coeffs[],int len){
@@ -64,7 +84,7 @@ long dotprod_sse2(void *p,signed short a[]){
   int al;
   signed short *ar;
   
-  ar = (signed short *)((int)a & ~15);
+  ar = (signed short *)((unsigned long)a & ~15);
   al = a - ar;
   
   /* Call assembler routine to do the work, passing number of 8-word blocks */
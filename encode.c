@@ -1,19 +1,22 @@
+#include <stdlib.h>
 #include "code.h"
+#include "fec.h"
 
 
-static inline int parity(unsigned long long x){
+static inline int parityll(unsigned long long x){
   return __builtin_parityll(x);
 }
 
 
 // Convolutionally encode a packet. The input data bytes are read
 // high bit first and the encoded packet is written into 'symbols',
-// one symbol per byte. The first symbol is generated from POLY1,
-// the second from POLY2.
+// one symbol per byte. The first symbol is generated from poly1,
+// the second from poly2.
 
 // Storing only one symbol per byte uses more space, but it is faster
 // and easier than trying to pack them more compactly.
-int encode(
+int encode_code(
+   const struct conv_code *code, // Code to use
    unsigned char *symbols,	// Output buffer, 2*8*nbytes
    const unsigned char *data,	// Input buffer, nbytes
    unsigned int nbytes)		// Number of bytes in data
@@ -25,12 +28,33 @@ int encode(
   while(nbytes-- != 0){
     for(i=7;i>=0;i--){  // Transmit MSB first
       encstate = ((encstate << 1) | ((*data >> i) & 1));
-      *symbols++ = G1FLIP ^ parity(encstate & POLY1);
-      *symbols++ = G2FLIP ^ parity(encstate & POLY2);
+      *symbols++ = code->g1flip ^ parityll(encstate & code->poly1);
+      *symbols++ = code->g2flip ^ parityll(encstate & code->poly2);
     }
     data++;
   }
-  if((encstate & ((1LL << K) -1)) != 0)
+  if((encstate & ((1LL << code->k) -1)) != 0)
     return -1;  // Warn if encoder wasn't tailed back to 0
   return 0;
 }
+
+// Encode with the default code
+int encode(
+   unsigned char *symbols,	// Output buffer, 2*8*nbytes
+   const unsigned char *data,	// Input buffer, nbytes
+   unsigned int nbytes)		// Number of bytes in data
+{
+  return encode_code(DEFAULT_CODE,symbols,data,nbytes);
+}
+
+// Table driven encoder for any code, a byte at a time. Much faster than
+// encode_code(), and it can pack the symbols
+void *create_encoder_code(const struct conv_code *code){
+  unsigned long long polys[2];
+
+  if(code == NULL)
+    code = DEFAULT_CODE;
+  polys[0] = code->poly1;
+  polys[1] = code->poly2;
+  return create_encoder(code->k,2,polys,(code->g2flip << 1) | code->g1flip);
+}
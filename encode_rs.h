@@ -15,6 +15,8 @@
  *            elements in index (log) form to polynomial form. Read only.
  * INDEX_OF - The address of an array of NN elements to convert Galois field
  *            elements in polynomial form to index (log) form. Read only.
+ * ALPHA_TO2 - Optional. The address of an array of 2*NN elements repeating ALPHA_TO,
+ *             so the sum of two logs can index it without MODNN. Read only.
  * MODNN - a function to reduce its argument modulo NN. May be inline or a macro.
  * GENPOLY - an array of NROOTS+1 elements containing the generator polynomial in index form
 
@@ -29,6 +31,12 @@
 
 #undef A0
 #define A0 (NN) /* Special reserved value encoding zero in index form */
+#undef EXP2
+#if defined(ALPHA_TO2)
+#define EXP2(x) ALPHA_TO2[x]
+#else
+#define EXP2(x) ALPHA_TO[MODNN(x)]
+#endif
 
 {
   int i, j;
@@ -46,12 +54,12 @@
       feedback = MODNN(NN - GENPOLY[NROOTS] + feedback);
 #endif
       for(j=1;j<NROOTS;j++)
-	parity[j] ^= ALPHA_TO[MODNN(feedback + GENPOLY[NROOTS-j])];
+	parity[j] ^= EXP2(feedback + GENPOLY[NROOTS-j]);
     }
     /* Shift */
     memmove(&parity[0],&parity[1],sizeof(data_t)*(NROOTS-1));
     if(feedback != A0)
-      parity[NROOTS-1] = ALPHA_TO[MODNN(feedback + GENPOLY[0])];
+      parity[NROOTS-1] = EXP2(feedback + GENPOLY[0]);
     else
       parity[NROOTS-1] = 0;
   }
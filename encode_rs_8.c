@@ -3,64 +3,42 @@
  * May be used under the terms of the GNU Lesser General Public License (LGPL)
  */
 #include <string.h>
+#include "fec.h"
 #include "fixed.h"
+#include "rs_encode.h"
 #ifdef __VEC__
 #include <sys/sysctl.h>
 #endif
 
-
-static enum {UNKNOWN=0,MMX,SSE,SSE2,ALTIVEC,PORT} cpu_mode;
-
 static void encode_rs_8_c(data_t *data, data_t *parity,int pad);
 #if __vec__
 static void encode_rs_8_av(data_t *data, data_t *parity,int pad);
 #endif
-#if __i386__
-int cpu_features(void);
-#endif
+
+/* Encoder tables, built on first use */
+static void *Encode_8;
 
 void encode_rs_8(data_t *data, data_t *parity,int pad){
-  if(cpu_mode == UNKNOWN){
-#ifdef __i386__
-    int f;
-    /* Figure out what kind of CPU we have */
-    f = cpu_features();
-    if(f & (1<<26)){ /* SSE2 is present */
-      cpu_mode = SSE2;
-    } else if(f & (1<<25)){ /* SSE is present */
-      cpu_mode = SSE;
-    } else if(f & (1<<23)){ /* MMX is present */
-      cpu_mode = MMX;
-    } else { /* No SIMD at all */
-      cpu_mode = PORT;
-    }
-#elif __VEC__
-    /* Ask the OS if we have Altivec support */
-    int selectors[2] = { CTL_HW, HW_VECTORUNIT };
-    int hasVectorUnit = 0;
-    size_t length = sizeof(hasVectorUnit);
-    int error = sysctl(selectors, 2, &hasVectorUnit, &length, NULL, 0);
-    if(0 == error && hasVectorUnit)
-      cpu_mode = ALTIVEC;
-    else
-      cpu_mode = PORT;
-#else
-    cpu_mode = PORT;
-#endif
-  }
-  switch(cpu_mode){
+  find_cpu_mode();
+  switch(Cpu_mode){
 #if __vec__
   case ALTIVEC:
     encode_rs_8_av(data,parity,pad);
     return;
-#endif
-#if __i386__
-  case MMX:
-  case SSE:
-  case SSE2:
 #endif
   default:
-    encode_rs_8_c(data,parity,pad);
+    if(__atomic_load_n(&Encode_8,__ATOMIC_ACQUIRE) == NULL){
+      void *sp,*expected = NULL;
+
+      if((sp = init_rs_encode(MM,ALPHA_TO,INDEX_OF,GENPOLY,NROOTS)) == NULL){
+	encode_rs_8_c(data,parity,pad);
+	return;
+      }
+      /* Another thread may have beaten us to it */
+      if(!__atomic_compare_exchange_n(&Encode_8,&expected,sp,0,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE))
+	free_rs_encode(sp);
+    }
+    rs_encode(Encode_8,parity,data,NN-NROOTS-pad);
     return;
   }
 }
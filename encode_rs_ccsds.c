@@ -3,14 +3,38 @@
  *
  * Copyright 2002, Phil Karn, KA9Q
  * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ *
+ * The basis change is linear, so it's folded into the encoder tables, which
+ * then take dual basis data and produce dual basis parity directly.
  */
-#include "ccsds.h"
+#include <stdlib.h>
 #include "fec.h"
+#include "fixed.h"
+#include "rs_encode.h"
+
+/* Encoder tables in the dual basis, built on first use */
+static void *Encode_ccsds;
 
 void encode_rs_ccsds(data_t *data,data_t *parity,int pad){
   int i;
   data_t cdata[NN-NROOTS];
 
+  if(__atomic_load_n(&Encode_ccsds,__ATOMIC_ACQUIRE) == NULL){
+    void *sp,*expected = NULL;
+
+    if((sp = init_rs_encode(MM,ALPHA_TO,INDEX_OF,GENPOLY,NROOTS)) == NULL
+       || rs_encode_basis(sp,Taltab,Tal1tab) != 0){
+      free_rs_encode(sp);
+      goto copy;
+    }
+    /* Another thread may have beaten us to it */
+    if(!__atomic_compare_exchange_n(&Encode_ccsds,&expected,sp,0,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE))
+      free_rs_encode(sp);
+  }
+  rs_encode(Encode_ccsds,parity,data,NN-NROOTS-pad);
+  return;
+
+ copy:
   /* Convert data from dual basis to conventional */
   for(i=0;i<NN-NROOTS-pad;i++)
     cdata[i] = Tal1tab[data[i]];
@@ -18,6 +42,6 @@ void encode_rs_ccsds(data_t *data,data_t *parity,int pad){
   encode_rs_8(cdata,parity,pad);
 
   /* Convert parity from conventional to dual basis */
-  for(i=0;i<NN-NROOTS-pad;i++)
+  for(i=0;i<NROOTS;i++)
     parity[i] = Taltab[parity[i]];
 }
@@ -6,10 +6,15 @@
 
 #include "char.h"
 #include "rs-common.h"
+#include "rs_encode.h"
 
 void encode_rs_char(void *p,data_t *data, data_t *parity){
   struct rs *rs = (struct rs *)p;
 
+  if(rs->enc != NULL){
+    rs_encode(rs->enc,parity,data,NN-NROOTS-PAD);
+    return;
+  }
 #include "encode_rs.h"
 
 }
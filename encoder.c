@@ -0,0 +1,177 @@
+/* Table driven convolutional encoders, a byte of data at a time
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ *
+ * A convolutional code is linear, so the symbols for a byte of input are the
+ * XOR of what the new byte would produce from the all-zeros state and what
+ * the state alone would produce with zero input. The latter splits the same
+ * way over the bytes of the state. Each piece is one lookup in a 256-entry
+ * table of 8*n-bit symbol patterns, so a byte costs 1 + (k+6)/8 lookups:
+ * two for K=7 and K=9, three for K=15, up to nine for K=64.
+ * Patterns are in transmission order, the first symbol of the first
+ * (most significant) data bit in the most significant bit.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "fec.h"
+
+#define MAXPOLYS 8 /* 8 symbols per bit fill a 64-bit pattern */
+
+struct encoder {
+  int k;                     /* Constraint length */
+  int n;                     /* Symbols per data bit */
+  int nbytes;                /* Bytes of old state that affect the output */
+  unsigned long long state;  /* Encoder shift register, newest bit in the LSB */
+  unsigned long long flips;  /* Pattern of inverted symbols for a byte */
+  unsigned long long tab[9][256]; /* [0] for the new byte, [j] for byte j-1 of the old state */
+};
+
+/* Expansion of a byte into 8 unpacked symbols, first symbol in the first byte */
+static unsigned char Unpack[256][8];
+static int Unpack_init;
+
+static inline int parityll(unsigned long long x){
+  return __builtin_parityll(x);
+}
+
+/* Symbol pattern for 8 data bits shifted into an encoder holding state */
+static unsigned long long pattern(const unsigned long long polys[],int n,unsigned long long state,int byte){
+  unsigned long long sr = state,pat = 0;
+  int i,p;
+
+  for(i=7;i>=0;i--){
+    sr = (sr << 1) | ((byte >> i) & 1);
+    for(p=0;p<n;p++)
+      pat = (pat << 1) | parityll(sr & polys[p]);
+  }
+  return pat;
+}
+
+/* Create an encoder for a rate 1/n code of constraint length k (up to 64)
+ * with the given polynomials, newest bit in the LSB as in the Viterbi decoders.
+ * Bit p of flips inverts the symbols from polys[p]
+ */
+void *create_encoder(int k,int n,const unsigned long long polys[],unsigned int flips){
+  struct encoder *ep;
+  int i,j,p;
+
+  if(k < 2 || k > 64 || n < 1 || n > MAXPOLYS)
+    return NULL;
+  if((ep = (struct encoder *)calloc(1,sizeof(struct encoder))) == NULL)
+    return NULL;
+  ep->k = k;
+  ep->n = n;
+  ep->nbytes = (k + 6) / 8;
+  for(i=0;i<256;i++){
+    ep->tab[0][i] = pattern(polys,n,0,i);
+    for(j=1;j<=ep->nbytes;j++)
+      ep->tab[j][i] = pattern(polys,n,(unsigned long long)i << (8*(j-1)),0);
+  }
+  for(i=0;i<8;i++)
+    for(p=0;p<n;p++)
+      ep->flips = (ep->flips << 1) | ((flips >> p) & 1);
+
+  if(!Unpack_init){
+    for(i=0;i<256;i++)
+      for(j=0;j<8;j++)
+	Unpack[i][j] = (i >> (7-j)) & 1;
+    Unpack_init = 1;
+  }
+  return ep;
+}
+
+/* Encoders for the codes with Viterbi decoders */
+void *create_encoder27(void){
+  unsigned long long polys[2] = {V27POLYA,V27POLYB};
+
+  return create_encoder(7,2,polys,0);
+}
+
+void *create_encoder29(void){
+  unsigned long long polys[2] = {V29POLYA,V29POLYB};
+
+  return create_encoder(9,2,polys,0);
+}
+
+void *create_encoder615(void){
+  unsigned long long polys[6] = {V615POLYA,V615POLYB,V615POLYC,V615POLYD,V615POLYE,V615POLYF};
+
+  return create_encoder(15,6,polys,0);
+}
+
+/* Set the encoder state, e.g., to 0 for the start of a frame */
+void init_encoder(void *p,unsigned long long state){
+  struct encoder *ep = p;
+
+  ep->state = state;
+}
+
+/* Symbol pattern for the next data byte; advances the state */
+static inline unsigned long long encode_byte(struct encoder *ep,int byte){
+  unsigned long long pat,state = ep->state;
+  int j;
+
+  pat = ep->tab[0][byte] ^ ep->flips;
+  for(j=1;j<=ep->nbytes;j++)
+    pat ^= ep->tab[j][(state >> (8*(j-1))) & 0xff];
+  ep->state = (state << 8) | byte;
+  return pat;
+}
+
+/* Encode nbytes of data, high bit first, writing 8*n symbols per byte,
+ * one per output byte as 0 or 1. Returns the encoder state afterward,
+ * only the low k-1 bits of which matter; they're 0 if the data ended with a tail
+ */
+unsigned long long encode_conv(void *p,unsigned char *symbols,const unsigned char *data,int nbytes){
+  struct encoder *ep = p;
+  unsigned long long pat;
+  int i,j,n = ep->n;
+
+  for(i=0;i<nbytes;i++){
+    pat = encode_byte(ep,data[i]);
+    for(j=n-1;j>=0;j--){
+      memcpy(symbols,Unpack[(pat >> (8*j)) & 0xff],8);
+      symbols += 8;
+    }
+  }
+  return ep->state & ((2ULL << (ep->k-2)) - 1);
+}
+
+/* As encode_conv(), but packing the symbols 8 to a byte, first one in the high bit,
+ * n bytes per byte of data
+ */
+unsigned long long encode_conv_packed(void *p,unsigned char *symbols,const unsigned char *data,int nbytes){
+  struct encoder *ep = p;
+  unsigned long long pat;
+  int i,j,n = ep->n;
+
+  for(i=0;i<nbytes;i++){
+    pat = encode_byte(ep,data[i]);
+    for(j=n-1;j>=0;j--)
+      *symbols++ = pat >> (8*j);
+  }
+  return ep->state & ((2ULL << (ep->k-2)) - 1);
+}
+
+void delete_encoder(void *p){
+  free(p);
+}
+
+/* Drop the symbols of nbits' worth of rate 1/2 encoder output that a
+ * puncturing pattern deletes, starting at the beginning of the pattern.
+ * out may be the same as in. Returns the number of symbols kept, or -1
+ * for a bad pattern
+ */
+int puncture_syms(unsigned char *out,const unsigned char *in,int nbits,const struct puncture *pp){
+  int i,n = 0,phase = 0;
+
+  if(pp->period < 1 || pp->period > MAXPUNCT)
+    return -1;
+  for(i=0;i<2*nbits;i++){
+    if(pp->keep[phase])
+      out[n++] = in[i];
+    if(++phase == 2*pp->period)
+      phase = 0;
+  }
+  return n;
+}
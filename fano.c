@@ -5,17 +5,52 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
 #include <math.h>
 #include <assert.h>
 #include "fano.h"
 #include "code.h"
 
+// The fields of a node touched on every move of the Fano loop. With 32-bit gamma
+// and 16-bit metrics it's 24 bytes; the old node, with the branch metrics and
+// long/int fields, was 48
 struct node {
-  unsigned long long encstate;	// Encoder state of next node
-  long gamma;		        // Cumulative metric to this node
-  int metrics[4];		// Metrics indexed by all possible tx syms
-  int tm[2];		        // Sorted metrics for current hypotheses
-  int i;			// Current branch being tested
+  uint64_t encstate;	// Encoder state of next node
+  int32_t gamma;	// Cumulative metric to this node
+  int16_t tm[2];	// Sorted metrics for current hypotheses
+  int i;		// Current branch being tested
+};
+
+// Decoder context. The hot part of each node is kept apart from the
+// branch metrics, which are only read on forward moves,
+// so the other moves don't drag them through the cache.
+struct fano {
+  const struct conv_code *code;
+  unsigned int maxbits;      // Nodes in the arena
+
+  struct node *nodes;        // Hot: touched on every move
+  int16_t (*metrics)[4];     // Cold: written once per frame, read once per forward move
+
+  // Branch symbol pairs contributed by each byte of the encoder state;
+  // the symbols for a state are the XOR of one entry per byte of K
+  int nchunks;               // Bytes of state that matter, (K+7)/8, or 0 to use parity()
+  uint8_t flips;             // Symbol inversions, g1flip in bit 1 and g2flip in bit 0
+  uint8_t symtab[4][256];
+
+  volatile int *cancel;      // If set and nonzero, give up at the next check
+
+  // Search state, kept here so a streaming decode can stop
+  // when it runs out of symbols and pick up again when more arrive
+  unsigned int nbits;        // Bits in the current frame, including tail
+  unsigned int avail;        // Bits whose symbols have arrived
+  unsigned int pos;          // Current node
+  long t;                    // Threshold
+  unsigned long cycle;       // Moves so far
+  unsigned long maxcycles;   // Moves allowed for the whole frame
+  int delta;                 // Threshold adjust parameter
+  int (*mettab)[256];        // Metric table, [sent sym][rx symbol]
 };
 
 static inline int parity(unsigned long long x){
@@ -23,145 +58,304 @@ static inline int parity(unsigned long long x){
 }
 
 // Given an encoder state, return a rate 1/2 symbol pair.
-// The POLY1 symbol goes into the next-to-LSB
-// of the result and the POLY2 symbol goes into the LSB.
-static inline int makesyms(unsigned long long state){
-  int result;
+// The poly1 symbol goes into the next-to-LSB
+// of the result and the poly2 symbol goes into the LSB.
+// The parities are linear in the state, so they can be done a byte at a time by
+// table lookup. That beats two 64-bit parities for K=24 (3 lookups) and ties at
+// K=32; for the longer codes the parities are faster, so nchunks == 0 selects them.
+// fano_run() is specialized on nchunks so all of this unrolls with no tests
+static inline int makesyms(const struct fano *fp,unsigned long long state,const int nchunks){
+  int result = fp->flips;
+  int j;
 
-  result = (parity(state & POLY1) << 1) ^ G1FLIP;
-  result |= parity(state & POLY2) ^ G2FLIP;
+  if(nchunks == 0)
+    return result ^ ((parity(state & fp->code->poly1) << 1) | parity(state & fp->code->poly2));
+  for(j=0;j<nchunks;j++)
+    result ^= fp->symtab[j][(state >> (8*j)) & 0xff];
   return result;
 }
 
-// Decode packet with the Fano algorithm.
-// Return 0 on success, -1 on timeout
+// Add two metric table entries, clamped to the range of the stored int16 branch metrics
+static inline int16_t branchmetric(int a,int b){
+  int m = a + b;
+
+  if(m > SHRT_MAX)
+    return SHRT_MAX;
+  if(m < SHRT_MIN)
+    return SHRT_MIN;
+  return m;
+}
+
+static int fano_run(struct fano *fp,unsigned long *metric,unsigned long *cycles,
+		    unsigned char *data,const unsigned char *symbols,unsigned int nbits,
+		    int mettab[2][256],int delta,unsigned long maxcycles);
+
+// Decode packet with the Fano algorithm, using the default code
 int fano(
-unsigned long *metric,	// Final path metric (returned value) 
-unsigned long *cycles,	// Cycle count (returned value) 
-unsigned char *data,	// Decoded output data 
-const unsigned char *symbols,	// Raw deinterleaved input symbols 
+unsigned long *metric,	// Final path metric (returned value)
+unsigned long *cycles,	// Cycle count (returned value)
+unsigned char *data,	// Decoded output data
+const unsigned char *symbols,	// Raw deinterleaved input symbols
 unsigned int nbits,	// Number of output bits, including tail
-int mettab[2][256],	// Metric table, [sent sym][rx symbol] 
-int delta,		// Threshold adjust parameter 
-unsigned long maxcycles)// Decoding timeout in cycles per bit 
+int mettab[2][256],	// Metric table, [sent sym][rx symbol]
+int delta,		// Threshold adjust parameter
+unsigned long maxcycles)// Decoding timeout in cycles per bit
 {
-  struct node *nodes;		// First node 
-  register struct node *np;	// Current node 
-  struct node *lastnode;	// Last node 
-  struct node *tail;		// First node of tail 
-  long t;			// Threshold 
-  long m0,m1;
-  long ngamma;
-  unsigned int lsym;
-  unsigned long i;
-  
-  if((nodes = (struct node *)malloc(nbits*sizeof(struct node))) == NULL){
-    fprintf(stderr,"alloc failed\n");
-    return 0;
+  return fano_code(DEFAULT_CODE,metric,cycles,data,symbols,nbits,mettab,delta,maxcycles);
+}
+
+// Decode packet with the Fano algorithm and any code, allocating the nodes for just this frame.
+// Return 0 on success, -1 on timeout or allocation failure
+int fano_code(
+const struct conv_code *code, // Code to decode
+unsigned long *metric,	// Final path metric (returned value)
+unsigned long *cycles,	// Cycle count (returned value)
+unsigned char *data,	// Decoded output data
+const unsigned char *symbols,	// Raw deinterleaved input symbols
+unsigned int nbits,	// Number of output bits, including tail
+int mettab[2][256],	// Metric table, [sent sym][rx symbol]
+int delta,		// Threshold adjust parameter
+unsigned long maxcycles)// Decoding timeout in cycles per bit
+{
+  void *fp;
+  int r;
+
+  if((fp = create_fano(nbits,code)) == NULL)
+    return -1;
+  r = fano_run(fp,metric,cycles,data,symbols,nbits,mettab,delta,maxcycles);
+  delete_fano(fp);
+  return r;
+}
+
+// Create a Fano decoder context for frames of up to maxbits (including tail), NULL code for the default
+void *create_fano(unsigned int maxbits,const struct conv_code *code){
+  struct fano *fp;
+  int j,b;
+
+  if(maxbits == 0 || (fp = (struct fano *)calloc(1,sizeof(struct fano))) == NULL)
+    return NULL;
+  fp->code = code != NULL ? code : DEFAULT_CODE;
+  fp->maxbits = maxbits;
+  fp->nodes = malloc(maxbits * sizeof(*fp->nodes));
+  fp->metrics = malloc(maxbits * sizeof(*fp->metrics));
+  if(fp->nodes == NULL || fp->metrics == NULL){
+    delete_fano(fp);
+    return NULL;
+  }
+  // Touch the whole arena now so decoding never takes a page fault
+  memset(fp->nodes,0,maxbits * sizeof(*fp->nodes));
+  memset(fp->metrics,0,maxbits * sizeof(*fp->metrics));
+
+  fp->nchunks = (fp->code->k + 7) / 8;
+  if(fp->nchunks < 3)
+    fp->nchunks = 3; // Shortest specialization; the extra bytes' entries are all 0
+  else if(fp->nchunks > 4)
+    fp->nchunks = 0;
+  fp->flips = (fp->code->g1flip << 1) | fp->code->g2flip;
+  for(j=0;j<4;j++){
+    for(b=0;b<256;b++){
+      unsigned long long state = (unsigned long long)b << (8*j);
+
+      fp->symtab[j][b] = (parity(state & fp->code->poly1) << 1) | parity(state & fp->code->poly2);
+    }
+  }
+  return fp;
+}
+
+// Decode a frame with a context; no allocation.
+// Return 0 on success, -1 on timeout or if the frame is too long
+int fano_decode(
+void *p,		// Decoder context from create_fano()
+unsigned long *metric,	// Final path metric (returned value)
+unsigned long *cycles,	// Cycle count (returned value)
+unsigned char *data,	// Decoded output data
+const unsigned char *symbols,	// Raw deinterleaved input symbols
+unsigned int nbits,	// Number of output bits, including tail
+int mettab[2][256],	// Metric table, [sent sym][rx symbol]
+int delta,		// Threshold adjust parameter
+unsigned long maxcycles)// Decoding timeout in cycles per bit
+{
+  struct fano *fp = p;
+
+  if(nbits > fp->maxbits)
+    return -1;
+  return fano_run(fp,metric,cycles,data,symbols,nbits,mettab,delta,maxcycles);
+}
+
+// Have a context's decodes give up soon after *cancel becomes nonzero (NULL to stop checking),
+// e.g., when another thread has already decoded the same frame
+void set_fano_cancel(void *p,volatile int *cancel){
+  struct fano *fp = p;
+
+  fp->cancel = cancel;
+}
+
+// Delete a Fano decoder context
+void delete_fano(void *p){
+  struct fano *fp = p;
+
+  if(fp != NULL){
+    free(fp->nodes);
+    free(fp->metrics);
+    free(fp);
   }
-  lastnode = &nodes[nbits];
-  tail = &nodes[nbits-(K-1)];
-  
-  // Compute all possible branch metrics for each symbol pair
-  // This is the only place we actually look at the raw input symbols
-  for(np=nodes;np < lastnode;np++){
-    np->metrics[0] = mettab[0][symbols[0]] + mettab[0][symbols[1]];
-    np->metrics[1] = mettab[0][symbols[0]] + mettab[1][symbols[1]];
-    np->metrics[2] = mettab[1][symbols[0]] + mettab[0][symbols[1]];
-    np->metrics[3] = mettab[1][symbols[0]] + mettab[1][symbols[1]];
+}
+
+// Compute all possible branch metrics for each symbol pair of n more bits.
+// This is the only place we actually look at the raw input symbols
+static void fano_metrics(struct fano *fp,const unsigned char *symbols,unsigned int n){
+  int16_t (*metrics)[4] = &fp->metrics[fp->avail];
+  int (*mettab)[256] = fp->mettab;
+  unsigned int i;
+
+  for(i=0;i<n;i++){
+    metrics[i][0] = branchmetric(mettab[0][symbols[0]],mettab[0][symbols[1]]);
+    metrics[i][1] = branchmetric(mettab[0][symbols[0]],mettab[1][symbols[1]]);
+    metrics[i][2] = branchmetric(mettab[1][symbols[0]],mettab[0][symbols[1]]);
+    metrics[i][3] = branchmetric(mettab[1][symbols[0]],mettab[1][symbols[1]]);
 #if 0
-    printf("k=%ld metrics %d %d %d %d\n",np-nodes,
-	   np->metrics[0],np->metrics[1],np->metrics[2],np->metrics[3]);
+    printf("k=%d metrics %d %d %d %d\n",fp->avail+i,
+	   metrics[i][0],metrics[i][1],metrics[i][2],metrics[i][3]);
 #endif
     symbols += 2;
   }
-  np = nodes;
-  np->encstate = 0;
-  
-  // Compute and sort branch metrics from root node 
-  lsym = makesyms(np->encstate);	// 0-branch (LSB is 0)
-
-  m0 = np->metrics[lsym];
-  
-  // Now do the 1-branch. To save another makesyms call here and
-  // inside the loop, we assume that both polynomials are odd,
-  // i.e., the least significant bits are 1, providing complementary pairs of branch symbols.
-  
-  // This code could be sped up if a systematic code were used.
-  m1 = np->metrics[3^lsym];
-  if(m0 > m1){
-    // 0-branch has better metric 
-    np->tm[0] = m0;
-    np->tm[1] = m1;
-  } else {
-    // 1-branch is better 
-    np->tm[0] = m1;
-    np->tm[1] = m0;
-    np->encstate |= 1;	// Set low bit 
+  fp->avail += n;
+}
+
+// Set up a new frame of nbits
+static void fano_start(struct fano *fp,unsigned int nbits,int mettab[2][256],int delta,unsigned long maxcycles){
+  fp->nbits = nbits;
+  fp->avail = 0;
+  fp->pos = 0;
+  fp->t = 0;
+  fp->cycle = 0;
+  fp->maxcycles = maxcycles * nbits;
+  fp->delta = delta;
+  fp->mettab = mettab;
+}
+
+// The Fano algorithm proper, on the context's arena, for a code nchunks bytes long (0 if longer than 4).
+// Searches as far as the symbols received so far allow.
+// Return 0 on success, 1 if it needs more symbols, -1 on timeout or cancellation
+static inline __attribute__((always_inline)) int fano_search_n(
+struct fano *fp,	// Decoder context
+const int nchunks)	// Bytes of encoder state that matter
+{
+  struct node *nodes = fp->nodes; // First node
+  struct node *np;		// Current node
+  struct node *limit;		// First node without symbols
+  struct node *tail;		// First node of tail
+  int16_t (*metrics)[4] = fp->metrics; // Branch metrics, indexed like nodes
+  long t = fp->t;		// Threshold
+  long m0,m1;
+  long ngamma;
+  unsigned int lsym;
+  unsigned long i = fp->cycle;
+  const unsigned long maxcycles = fp->maxcycles;
+  const int delta = fp->delta;
+  int r;
+
+  limit = &nodes[fp->avail];
+  tail = &nodes[fp->nbits-(fp->code->k-1)];
+  np = &nodes[fp->pos];
+
+  if(i == 0){
+    // Not started yet
+    if(fp->avail == 0)
+      return 1;
+    np->encstate = 0;
+
+    // Compute and sort branch metrics from root node
+    lsym = makesyms(fp,np->encstate,nchunks);	// 0-branch (LSB is 0)
+
+    m0 = metrics[0][lsym];
+
+    // Now do the 1-branch. To save another makesyms call here and
+    // inside the loop, we assume that both polynomials are odd,
+    // i.e., the least significant bits are 1, providing complementary pairs of branch symbols.
+
+    // This code could be sped up if a systematic code were used.
+    m1 = metrics[0][3^lsym];
+    if(m0 > m1){
+      // 0-branch has better metric
+      np->tm[0] = m0;
+      np->tm[1] = m1;
+    } else {
+      // 1-branch is better
+      np->tm[0] = m1;
+      np->tm[1] = m0;
+      np->encstate |= 1;	// Set low bit
+    }
+    np->i = 0;	// Start with best branch
+    np->gamma = t = 0;
+    i = 1;
   }
-  np->i = 0;	// Start with best branch 
-  maxcycles *= nbits;
-  np->gamma = t = 0;
-  
-  // Start the Fano decoder 
-  for(i=1;i <= maxcycles;i++){
+  // Run the Fano decoder
+  for(;i <= maxcycles;i++){
+    // Poll for cancellation now and then; the flag is written by another thread
+    if((i & 1023) == 0 && fp->cancel != NULL && *fp->cancel){
+      r = -1;
+      goto out;
+    }
 
     //#define debug 1
 #ifdef	debug
-    fprintf(stdout,"k=%d, encoder 0x%06llx, metric=%ld, thresh=%ld, m[%d]=%d\n",
-	    (int)(np-nodes),np->encstate & ((1LL<<K)-1),np->gamma,t,np->i,np->tm[np->i]);
+    fprintf(stdout,"k=%d, encoder 0x%06llx, metric=%d, thresh=%ld, m[%d]=%d\n",
+	    (int)(np-nodes),(unsigned long long)np->encstate & ((1LL<<fp->code->k)-1),np->gamma,t,
+	    np->i,np->tm[np->i]);
 #endif
-    // Look forward 
+    // Look forward
     ngamma = np->gamma + np->tm[np->i];
-    //    printf("np->gamma = %ld, ngamma = %ld\n",np->gamma,ngamma);
     if(ngamma >= t){
-      // Node is acceptable 
+      // Node is acceptable
       if(np->gamma < t + delta){
 	// First time we've visited this node; tighten threshold.
-	
+
 	// This loop could be replaced with
 	//   t += delta * ((ngamma - t)/delta);
 	// but the multiply and divide are slower.
 	while(ngamma >= t + delta)
 	  t += delta;
       }
-      // Move forward 
-      if(++np == lastnode){
+      // Move forward
+      if(++np == limit){
 	np--;
-	break;	// Done! 
+	if(fp->avail == fp->nbits){
+	  r = 0;
+	  goto out;	// Done!
+	}
+	// Out of symbols. Stop here and repeat this move when more arrive;
+	// the threshold won't tighten again
+	r = 1;
+	goto out;
       }
       np->gamma = ngamma;
       np->encstate = np[-1].encstate << 1;
-      
+
       // Compute and sort metrics, starting with the zero branch
-      lsym = makesyms(np->encstate);
+      lsym = makesyms(fp,np->encstate,nchunks);
       if(np >= tail){
 	// The tail must be all zeroes, so don't even
 	// bother computing the 1-branches there.
-	np->tm[0] = np->metrics[lsym];
+	np->tm[0] = metrics[np-nodes][lsym];
       } else {
-	m0 = np->metrics[lsym];
-	m1 = np->metrics[3^lsym];
-#if 0
-	printf("m0 = %ld, m1 = %ld\n",m0,m1);
-#endif
-	if(m0 > m1){
-	  // 0-branch is better 
-	  np->tm[0] = m0;
-	  np->tm[1] = m1;
-	} else {
-	  // 1-branch is better 
-	  np->tm[0] = m1;
-	  np->tm[1] = m0;
-	  np->encstate++;	// Set low bit 
-	}
+	int better1;
+
+	m0 = metrics[np-nodes][lsym];
+	m1 = metrics[np-nodes][3^lsym];
+	// Which branch is better is a coin toss in noise, so sort without branching:
+	// the 1-branch wins ties, and then its low bit is set
+	better1 = m1 >= m0;
+	np->tm[0] = better1 ? m1 : m0;
+	np->tm[1] = better1 ? m0 : m1;
+	np->encstate += better1;
       }
-      np->i = 0;	// Start with best branch 
+      np->i = 0;	// Start with best branch
       continue;
     }
-    // Threshold violated, can't go forward 
+    // Threshold violated, can't go forward
     for(;;){
-      // Look backward 
+      // Look backward
       if(np == nodes || np[-1].gamma < t){
 	// Can't back up either.
 	// Relax threshold and and look forward again to better branch.
@@ -172,28 +366,95 @@ unsigned long maxcycles)// Decoding timeout in cycles per bit
 	}
 	break;
       }
-      // Back up 
+      // Back up
       if(--np < tail && np->i != 1){
-	// Search next best branch 
+	// Search next best branch
 	np->i++;
 	np->encstate ^= 1;
 	break;
-      } // else keep looking back 
+      } // else keep looking back
     }
   }
-  *metric =  np->gamma;	// Return final path metric 
-  
-  // Copy decoded data to user's buffer 
-  nbits = nbits/8;	// Copy tail, which should be 0's
-  np = &nodes[7]; // Start with first full byte
-  while(nbits-- != 0){
+  r = -1;	// Decoder timed out
+ out:
+  fp->pos = np - nodes;
+  fp->t = t;
+  fp->cycle = i;
+  return r;
+}
+
+// Search with the copy of the Fano loop specialized for the code's length
+static int fano_search(struct fano *fp){
+  switch(fp->nchunks){
+  case 3:  // K=24
+    return fano_search_n(fp,3);
+  case 4:  // K=32
+    return fano_search_n(fp,4);
+  default: // K=47, 48 and up to 64
+    return fano_search_n(fp,0);
+  }
+}
+
+// Report the outcome of a search that returned r
+static int fano_result(struct fano *fp,int r,unsigned long *metric,unsigned long *cycles,unsigned char *data){
+  struct node *np;
+  unsigned int nbytes;
+
+  *metric = fp->nodes[fp->pos].gamma;	// Return final path metric
+  *cycles = fp->cycle;
+
+  // Copy decoded data to user's buffer, even if it's only partly decoded
+  nbytes = fp->nbits/8;	// Copy tail, which should be 0's
+  np = &fp->nodes[7]; // Start with first full byte
+  while(nbytes-- != 0){
     *data++ = np->encstate;
     np += 8;
   }
-  
-  free(nodes);
-  *cycles = i;
-  if(i > maxcycles)
-    return -1;	// Decoder timed out 
-  return 0;	// Successful completion 
+  if(r != 0)
+    return -1;	// Timed out or cancelled
+  return 0;	// Successful completion
+}
+
+// Decode a whole frame on the context's arena. Return 0 on success, -1 on timeout or cancellation
+static int fano_run(struct fano *fp,unsigned long *metric,unsigned long *cycles,
+		    unsigned char *data,const unsigned char *symbols,unsigned int nbits,
+		    int mettab[2][256],int delta,unsigned long maxcycles){
+  fano_start(fp,nbits,mettab,delta,maxcycles);
+  fano_metrics(fp,symbols,nbits);
+  return fano_result(fp,fano_search(fp),metric,cycles,data);
+}
+
+// Start decoding a frame of nbits (including tail) whose symbols will arrive a piece at a time
+// through update_fano_stream(). Return 0, or -1 if the frame is too long
+int init_fano_stream(void *p,unsigned int nbits,int mettab[2][256],int delta,unsigned long maxcycles){
+  struct fano *fp = p;
+
+  if(nbits > fp->maxbits || nbits < (unsigned int)fp->code->k)
+    return -1;
+  fano_start(fp,nbits,mettab,delta,maxcycles);
+  return 0;
+}
+
+// Add the symbols for the next n bits of the frame and take the search as far as they allow,
+// so decoding overlaps reception and is mostly done when the tail arrives.
+// Return 1 while it needs more symbols. Once it has them all,
+// return 0 with the decoded data, metric and cycles filled in, or -1 if it timed out
+int update_fano_stream(
+void *p,		// Decoder context from create_fano(), set up by init_fano_stream()
+unsigned long *metric,	// Final path metric (returned value)
+unsigned long *cycles,	// Cycle count (returned value)
+unsigned char *data,	// Decoded output data
+const unsigned char *symbols,	// Next raw deinterleaved input symbols, 2 per bit
+unsigned int n)		// Number of bits they're for
+{
+  struct fano *fp = p;
+  int r;
+
+  if(n > fp->nbits - fp->avail)
+    n = fp->nbits - fp->avail; // Ignore anything past the end of the frame
+  fano_metrics(fp,symbols,n);
+  r = fano_search(fp);
+  if(r == 1)
+    return 1;
+  return fano_result(fp,r,metric,cycles,data);
 }
@@ -2,6 +2,37 @@ int fano(unsigned long *metric, unsigned long *cycles,
 	unsigned char *data,const unsigned char *symbols,
 	unsigned int nbits,int mettab[2][256],int delta,
 	unsigned long maxcycles);
+struct conv_code;
+int fano_code(const struct conv_code *code,unsigned long *metric, unsigned long *cycles,
+	unsigned char *data,const unsigned char *symbols,
+	unsigned int nbits,int mettab[2][256],int delta,
+	unsigned long maxcycles);
+// Decoder context that reuses one node arena for every frame
+void *create_fano(unsigned int maxbits,const struct conv_code *code);
+int fano_decode(void *fp,unsigned long *metric, unsigned long *cycles,
+	unsigned char *data,const unsigned char *symbols,
+	unsigned int nbits,int mettab[2][256],int delta,
+	unsigned long maxcycles);
+void set_fano_cancel(void *fp,volatile int *cancel);
+// Streaming decode of a frame whose symbols arrive a piece at a time
+int init_fano_stream(void *fp,unsigned int nbits,int mettab[2][256],int delta,unsigned long maxcycles);
+int update_fano_stream(void *fp,unsigned long *metric, unsigned long *cycles,
+	unsigned char *data,const unsigned char *symbols,unsigned int n);
+void delete_fano(void *fp);
+// Several Fano decoders racing on the same frame with different deltas, one per thread
+void *create_fano_mt(unsigned int maxbits,const struct conv_code *code,int nvariants,const int deltas[]);
+int fano_decode_mt(void *fp,unsigned long *metric, unsigned long *cycles,
+	unsigned char *data,const unsigned char *symbols,
+	unsigned int nbits,int mettab[2][256],
+	unsigned long maxcycles);
+void delete_fano_mt(void *fp);
+// Stack algorithm decoder with a bounded node pool
+void *create_stack(unsigned int maxbits,unsigned int maxnodes,const struct conv_code *code);
+int stack_decode(void *sp,unsigned long *metric, unsigned long *cycles,
+	unsigned char *data,const unsigned char *symbols,
+	unsigned int nbits,int mettab[2][256],int delta,
+	unsigned long maxcycles);
+void delete_stack(void *sp);
 int encode(unsigned char *symbols,const unsigned char *data,unsigned int nbytes);
 void gen_met(int mettab[2][256],double signal,double noise,double bias,double scale);
 
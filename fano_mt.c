@@ -0,0 +1,227 @@
+// Parallel Fano decoding: several threshold spacings racing on the same frame
+// Copyright 2026, Phil Karn, KA9Q
+// May be used under the terms of the GNU Lesser General Public License (LGPL)
+//
+// How long the Fano algorithm takes on a noisy frame depends heavily on delta,
+// and the best delta for one frame is often a poor one for the next. Running a
+// few deltas at once on otherwise idle cores and taking whichever finishes first
+// cuts the tail of the decode time distribution. The losers are cancelled as
+// soon as there's a winner, so they only burn cycles while the race is open.
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "fano.h"
+
+#define MAXVARIANTS 16
+
+struct fano_variant {
+  void *fp;               // Decoder context with its own node arena
+  int delta;              // Threshold spacing for this variant
+  pthread_t thread;
+  unsigned char *data;    // Decoded output
+  unsigned long metric;
+  unsigned long cycles;
+  int result;
+};
+
+struct fano_mt {
+  int nvariants;          // Variant 0 runs in the caller's thread
+  struct fano_variant v[MAXVARIANTS];
+  pthread_barrier_t barrier;
+  pthread_mutex_t gate_lock; // Holds new workers until the whole pool has started
+  pthread_cond_t gate_cond;
+  int gate;               // 0 closed, 1 go, -1 quit
+
+  // Current job, published before the starting barrier
+  const unsigned char *symbols;
+  unsigned int nbits;     // 0 tells the workers to exit
+  int (*mettab)[256];
+  unsigned long maxcycles;
+
+  volatile int cancel;    // Set by the winner to stop the others
+  int winner;             // Index of the first variant to succeed, -1 if none yet
+};
+
+struct fano_worker {
+  struct fano_mt *mp;
+  int id;
+};
+
+// Run one variant on the current job, claiming the win if it's first to succeed
+static void run_variant(struct fano_mt *mp,int id){
+  struct fano_variant *vp = &mp->v[id];
+
+  vp->result = fano_decode(vp->fp,&vp->metric,&vp->cycles,vp->data,mp->symbols,
+			   mp->nbits,mp->mettab,vp->delta,mp->maxcycles);
+  if(vp->result == 0){
+    int expected = -1;
+
+    if(__atomic_compare_exchange_n(&mp->winner,&expected,id,0,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE))
+      mp->cancel = 1;
+  }
+}
+
+// Let the workers held at the start gate go, or tell them to quit
+static void open_gate(struct fano_mt *mp,int gate){
+  pthread_mutex_lock(&mp->gate_lock);
+  mp->gate = gate;
+  pthread_cond_broadcast(&mp->gate_cond);
+  pthread_mutex_unlock(&mp->gate_lock);
+}
+
+static void *fano_worker(void *arg){
+  struct fano_worker *w = arg;
+  struct fano_mt *mp = w->mp;
+  int id = w->id,gate;
+
+  free(w);
+  // The barrier doesn't exist until every worker has started
+  pthread_mutex_lock(&mp->gate_lock);
+  while((gate = mp->gate) == 0)
+    pthread_cond_wait(&mp->gate_cond,&mp->gate_lock);
+  pthread_mutex_unlock(&mp->gate_lock);
+  if(gate < 0)
+    return NULL;
+
+  for(;;){
+    // Wait for the caller to publish a job
+    pthread_barrier_wait(&mp->barrier);
+    if(mp->nbits == 0)
+      break;
+    run_variant(mp,id);
+    // Tell the caller we're done
+    pthread_barrier_wait(&mp->barrier);
+  }
+  return NULL;
+}
+
+// Create a parallel decoder for frames of up to maxbits (including tail) with the given code
+// (NULL for the default), running nvariants Fano decoders with deltas[0..nvariants-1].
+// The caller's thread runs the first; the rest each get their own
+void *create_fano_mt(unsigned int maxbits,const struct conv_code *code,int nvariants,const int deltas[]){
+  struct fano_mt *mp;
+  int i,j;
+
+  if(nvariants < 1 || nvariants > MAXVARIANTS)
+    return NULL;
+  if((mp = (struct fano_mt *)calloc(1,sizeof(struct fano_mt))) == NULL)
+    return NULL;
+  for(i=0;i<nvariants;i++){
+    if((mp->v[i].fp = create_fano(maxbits,code)) == NULL
+       || (mp->v[i].data = malloc(maxbits/8)) == NULL){
+      delete_fano_mt(mp);
+      return NULL;
+    }
+    mp->v[i].delta = deltas[i];
+    set_fano_cancel(mp->v[i].fp,&mp->cancel);
+  }
+  if(nvariants == 1){
+    mp->nvariants = 1;
+    return mp;
+  }
+  if(pthread_mutex_init(&mp->gate_lock,NULL) != 0){
+    delete_fano_mt(mp);
+    return NULL;
+  }
+  if(pthread_cond_init(&mp->gate_cond,NULL) != 0){
+    pthread_mutex_destroy(&mp->gate_lock);
+    delete_fano_mt(mp);
+    return NULL;
+  }
+  mp->gate = 0;
+  for(i=1;i<nvariants;i++){
+    struct fano_worker *w;
+
+    if((w = malloc(sizeof(struct fano_worker))) == NULL)
+      break;
+    w->mp = mp;
+    w->id = i;
+    if(pthread_create(&mp->v[i].thread,NULL,fano_worker,w) != 0){
+      free(w);
+      break;
+    }
+  }
+  if(i < nvariants || pthread_barrier_init(&mp->barrier,NULL,nvariants) != 0){
+    // Send home the workers that did start
+    open_gate(mp,-1);
+    for(j=1;j<i;j++)
+      pthread_join(mp->v[j].thread,NULL);
+    pthread_cond_destroy(&mp->gate_cond);
+    pthread_mutex_destroy(&mp->gate_lock);
+    delete_fano_mt(mp);
+    return NULL;
+  }
+  mp->nvariants = nvariants;
+  open_gate(mp,1);
+  return mp;
+}
+
+// Decode a frame with every variant at once, keeping the first to finish.
+// metric and data come from the winner; cycles is the winner's count.
+// Return the index of the winning variant, or -1 if they all timed out
+int fano_decode_mt(
+void *p,		// Decoder from create_fano_mt()
+unsigned long *metric,	// Final path metric (returned value)
+unsigned long *cycles,	// Cycle count (returned value)
+unsigned char *data,	// Decoded output data
+const unsigned char *symbols,	// Raw deinterleaved input symbols
+unsigned int nbits,	// Number of output bits, including tail
+int mettab[2][256],	// Metric table, [sent sym][rx symbol]
+unsigned long maxcycles)// Decoding timeout in cycles per bit, for each variant
+{
+  struct fano_mt *mp = p;
+  struct fano_variant *vp;
+
+  if(nbits == 0)
+    return -1;
+  mp->symbols = symbols;
+  mp->nbits = nbits;
+  mp->mettab = mettab;
+  mp->maxcycles = maxcycles;
+  mp->cancel = 0;
+  mp->winner = -1;
+
+  if(mp->nvariants > 1)
+    pthread_barrier_wait(&mp->barrier); // Start the workers
+  run_variant(mp,0);
+  if(mp->nvariants > 1)
+    pthread_barrier_wait(&mp->barrier); // Wait for the rest to finish or give up
+
+  if(mp->winner >= 0){
+    vp = &mp->v[mp->winner];
+    *metric = vp->metric;
+    *cycles = vp->cycles;
+    memcpy(data,vp->data,nbits/8);
+    return mp->winner;
+  }
+  // Everybody timed out; report the first variant's partial decode, as fano() would
+  vp = &mp->v[0];
+  *metric = vp->metric;
+  *cycles = vp->cycles;
+  memcpy(data,vp->data,nbits/8);
+  return -1;
+}
+
+// Delete a parallel Fano decoder, stopping its threads
+void delete_fano_mt(void *p){
+  struct fano_mt *mp = p;
+  int i;
+
+  if(mp == NULL)
+    return;
+  if(mp->nvariants > 1){
+    // Release the workers with an exit job
+    mp->nbits = 0;
+    pthread_barrier_wait(&mp->barrier);
+    for(i=1;i<mp->nvariants;i++)
+      pthread_join(mp->v[i].thread,NULL);
+    pthread_barrier_destroy(&mp->barrier);
+    pthread_cond_destroy(&mp->gate_cond);
+    pthread_mutex_destroy(&mp->gate_lock);
+  }
+  for(i=0;i<MAXVARIANTS;i++){
+    delete_fano(mp->v[i].fp);
+    free(mp->v[i].data);
+  }
+  free(mp);
+}
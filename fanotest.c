@@ -6,7 +6,10 @@
 #include <assert.h>
 #include <getopt.h>
 #include "fano.h"
+#include "code.h"
 #include "sim.h"
+#include "montecarlo.h"
+#include "fec.h"
 
 
 
@@ -17,8 +20,15 @@ struct option Options[] = {
   {"frame-length",1,NULL,'l'},
   {"frame-count",1,NULL,'n'},
   {"ebn0",1,NULL,'e'},
+  {"ebn0-max",1,NULL,'x'},
+  {"ebn0-step",1,NULL,'i'},
   {"gain",1,NULL,'g'},
   {"verbose",0,NULL,'v'},
+  {"code",1,NULL,'c'},
+  {"chunk",1,NULL,'k'},
+  {"threads",1,NULL,'j'},
+  {"seed",1,NULL,'r'},
+  {"max-errors",1,NULL,'f'},
   {NULL},
 };
 
@@ -28,22 +38,156 @@ double Signal = 30;              // Signal amplitude (scaled to 8 bit byte)
 int Scale = 8;             // Fano metric scaling factor
 const double Rate = 0.5;         // Code rate = 1/2
 double Ebn0 = 2.0;               // Digital signal-to-noise ratio per bit in dB
+double Ebn0_max = -1;            // Last Eb/N0 of a sweep, if above Ebn0
+double Ebn0_step = 0.5;          // Eb/N0 increment in a sweep
 unsigned long Maxcycles = 1000;  // Maximum number of decoder moves per bit
 int Trials = 1000;               // Number of frames to test
 int Verbose;                     // diag diarrhea
 int Zerodata;                    // Use all 0's data (no effect on linear codes)
+const struct conv_code *Code = DEFAULT_CODE; // Convolutional code
+int Chunk;                       // If nonzero, feed the decoder this many bits of symbols at a time
+int Nthreads = 1;                // Simulation threads, each with its own decoder
+long Max_errors;                 // Move on to the next Eb/N0 after this many frame errors
+int Delta;                       // Threshold adjust parameter, scaled
+int Mettab[2][256];              // Metric table for the current Eb/N0
 
-int main(int argc,char *argv[]){
-  int mettab[2][256];
-  unsigned char data[Nbits/8],symbols[Nbits*2],decode_data[Nbits/8];
+// One simulation thread's decoder and buffers
+struct fanotest {
+  void *fp;
+  void *enc;
+  unsigned char *data,*symbols,*decode_data;
+};
+
+static void *create_fanotest(void *arg){
+  struct fanotest *ft;
+
+  if((ft = calloc(1,sizeof(*ft))) == NULL)
+    return NULL;
+  ft->data = malloc(Nbits/8);
+  ft->decode_data = malloc(Nbits/8);
+  ft->symbols = malloc(2*Nbits);
+  ft->enc = create_encoder_code(Code);
+  if((ft->fp = create_fano(Nbits,Code)) == NULL || ft->enc == NULL || ft->data == NULL || ft->decode_data == NULL || ft->symbols == NULL){
+    printf("create_fano failed\n");
+    delete_fano(ft->fp);
+    delete_encoder(ft->enc);
+    free(ft->data);
+    free(ft->decode_data);
+    free(ft->symbols);
+    free(ft);
+    return NULL;
+  }
+  return ft;
+}
+
+static void delete_fanotest(void *p){
+  struct fanotest *ft = p;
+
+  delete_fano(ft->fp);
+  delete_encoder(ft->enc);
+  free(ft->data);
+  free(ft->decode_data);
+  free(ft->symbols);
+  free(ft);
+}
+
+// Encode, add noise to and decode one frame
+static void fanotest_trial(void *p,struct sim_rng *rng,long trial,struct mc_counts *counts){
+  struct fanotest *ft = p;
+  unsigned char *data = ft->data,*symbols = ft->symbols,*decode_data = ft->decode_data;
   unsigned long cycles, metric;
+  int i,r,e;
+
+  memset(data,0,Nbits/8);
+  if(!Zerodata){
+    // Generate random data
+    // Note last 3 bytes must be 0 to tail off the encoder
+    for(i=0;i<(Nbits-64)/8;i++)      // allow room on end for max length tail
+      data[i] = sim_rand64(rng) & 0xff;
+  }
+  init_encoder(ft->enc,0);
+  i = encode_conv(ft->enc,symbols,data,Nbits/8);
+  assert(i == 0);
+
+#if 0
+  printf("raw data and symbols, no noise:\n");
+  for(i=0;i<Nbits;i++){
+    if((i % 8) == 0)
+      printf("data[%d] = %02x; symbols = ",i/8,data[i/8]);
+    printf("%d%d",symbols[2*i],symbols[2*i+1]);
+    if((i % 8) == 7)
+      putchar('\n');
+  }
+  putchar('\n');
+#endif
+
+  // Add noise & scale
+  for(i=0;i<2*Nbits;i++)
+    symbols[i] = simulate_r(rng,symbols[i]);
+
+#if 0
+  printf("data and symbols, noisy & scaled:\n");
+  for(i=0;i<Nbits;i++){
+    if((i % 8) == 0)
+      printf("data[%d] = %02x; symbols = ",i/8,data[i/8]);
+    printf(" %03d %03d",symbols[2*i],symbols[2*i+1]);
+    if((i % 8) == 7)
+      putchar('\n');
+  }
+  putchar('\n');
+#endif
+  memset(decode_data,0,Nbits/8);
+  if(Chunk > 0){
+    // Hand over the symbols as if they were arriving from the demodulator
+    int n;
+
+    init_fano_stream(ft->fp,Nbits,Mettab,Delta,Maxcycles);
+    for(i=0;;i += n){
+      n = Nbits - i < Chunk ? Nbits - i : Chunk;
+      if((r = update_fano_stream(ft->fp,&metric,&cycles,decode_data,symbols+2*i,n)) != 1)
+	break;
+    }
+  } else
+    r = fano_decode(ft->fp,&metric,&cycles,decode_data,symbols,Nbits,Mettab,Delta,Maxcycles);
+
+  counts->trials++;
+  counts->bits += Nbits;
+  counts->cycles += cycles;
+  e = 0;
+  for(i=0;i<Nbits/8;i++)
+    e += __builtin_popcount(data[i] ^ decode_data[i]);
+  // A frame the decoder gave up on is an erasure, and what's left in its
+  // buffer isn't a decision, so only count bit errors it didn't catch
+  if(r == 0)
+    counts->bit_errors += e;
+  counts->frame_errors += (e != 0 || r != 0);
+  counts->failures += (r != 0);
+  counts->undetected += (r == 0 && e != 0);
+
+  if(Verbose > 1 || (Verbose && r != 0)){
+    printf("trial %ld fano returns %d, metric = %ld, cycles = %ld",trial,r,metric,cycles);
+    if(e != 0 && (Verbose > 1 || r == 0)){
+      // Error in data
+      putchar(' ');
+      for(i=0;i<Nbits/8;i++)
+	printf("%02x",decode_data[i] ^ data[i]);
+    }
+    putchar('\n');
+  }
+}
+
+int main(int argc,char *argv[]){
   int delta = 4;
   time_t t;
-  int trial,i,r,good=0,bad=0,undetected=0;
-  long totcycles = 0,histogram[256];
+  int i;
   double noise_amp; // Actual noise amplitude, computed from Signal amplitude & Eb/N0
+  double ebn0;
+  struct mc_job job;
+  struct mc_counts counts;
 
-  while((i = getopt_long(argc,argv,"d:S:l:n:e:s:m:vz",Options,NULL)) != EOF){
+  memset(&job,0,sizeof(job));
+  job.seed = time(&t);
+  while((i = getopt_long(argc,argv,"d:S:l:n:e:x:i:s:m:vzc:k:j:r:f:",Options,NULL)) != EOF){
     switch(i){
     case 'd':
       delta = atoi(optarg);
@@ -63,6 +207,12 @@ int main(int argc,char *argv[]){
     case 'e':
       Ebn0 = atof(optarg);
       break;
+    case 'x':
+      Ebn0_max = atof(optarg);
+      break;
+    case 'i':
+      Ebn0_step = atof(optarg);
+      break;
     case 's':
       Signal = atof(optarg);
       break;
@@ -72,8 +222,26 @@ int main(int argc,char *argv[]){
     case 'z':
       Zerodata++;
       break;
+    case 'c':
+      if((Code = find_conv_code(optarg)) == NULL){
+	printf("Unknown code %s\n",optarg);
+	exit(1);
+      }
+      break;
+    case 'k':
+      Chunk = atoi(optarg);
+      break;
+    case 'j':
+      Nthreads = atoi(optarg);
+      break;
+    case 'r':
+      job.seed = strtoull(optarg,NULL,0);
+      break;
+    case 'f':
+      Max_errors = atol(optarg);
+      break;
     default:
-      printf("Usage: %s [-m maxcycles/bit] [-l bits/frame] [-n numframes] [-e Eb/No] [-s signal_amplitude] [-v] [-z]\n",
+      printf("Usage: %s [-m maxcycles/bit] [-l bits/frame] [-n numframes] [-e Eb/No] [-x max_Eb/No] [-i Eb/No_step] [-s signal_amplitude] [-c code] [-k chunk_bits] [-j threads] [-r seed] [-f max_frame_errors] [-v] [-z]\n",
 	     argv[0]);
       exit(1);
       break;
@@ -83,96 +251,39 @@ int main(int argc,char *argv[]){
     printf("bits/frame must be >= 64\n");
     exit(1);
   }
-  delta *= Scale;
-
-  // Compute noise voltage. The factor of 2 accounts for BPSK seeing
-  // only half the noise power, and the sqrt() converts power to voltage
-  noise_amp = Signal / sqrt(2*Rate*pow(10.,Ebn0/10.));
-  gen_met(mettab,Signal,noise_amp,Rate,Scale);
-
-  // Generate channel transition matrix
-  setup_channel(Signal,noise_amp);
-
-  printf("Code rate %.2f, Nbits = %d, Maxcycles/bit %ld\n",Rate,Nbits,Maxcycles);
-  printf("Eb/N0 = %.3lf dB, Signal = %lg, Noise = %lg, BER@Eb/N0 = %lg, BER@Es/N0 = %lg\n",
-	 Ebn0,Signal,noise_amp,0.5*erfc(pow(10.,Ebn0/20.)),0.5*erfc(sqrt(Rate*pow(10.,Ebn0/10.))));
-  
-  srandom(time(&t));
-
-  memset(histogram,0,sizeof(histogram));
-  memset(data,0,sizeof(data));
-  for(trial = 0; trial < Trials; trial++){
-
-    if(!Zerodata){
-      // Generate random data
-      // Note last 3 bytes must be 0 to tail off the encoder
-      for(i=0;i<(Nbits-64)/8;i++)      // allow room on end for max length tail
-	data[i] = random() & 0xff;
-
-      for(;i<Nbits/8;i++)
-	data[i] = 0;
-    }
-    i =  encode(symbols,data,sizeof(data));
-    assert(i == 0);
-    
-#if 0
-    printf("raw data and symbols, no noise:\n");
-    for(i=0;i<Nbits;i++){
-      if((i % 8) == 0)
-	printf("data[%d] = %02x; symbols = ",i/8,data[i/8]);
-      printf("%d%d",symbols[2*i],symbols[2*i+1]);
-      if((i % 8) == 7)
-	putchar('\n');
-    }
-    putchar('\n');
-#endif
-    
-    // Add noise & scale, build histogram
-    for(i=0;i<2*Nbits;i++){
-      symbols[i] = simulate(symbols[i]);
-      histogram[symbols[i]]++;
-    }
-#if 0
-    printf("data and symbols, noisy & scaled:\n");
-    for(i=0;i<Nbits;i++){
-      if((i % 8) == 0)
-	printf("data[%d] = %02x; symbols = ",i/8,data[i/8]);
-      printf(" %03d %03d",symbols[2*i],symbols[2*i+1]);
-      if((i % 8) == 7)
-	putchar('\n');
-    }
-    putchar('\n');
-#endif
-    if(Verbose > 2){
-      printf("Cumulative symbol histogram:\n");
-      for(i=0;i<256;i++){
-	printf(" %6ld",histogram[i]);
-	if((i % 16) == 15)
-	  putchar('\n');
-      }
-    }
-    memset(decode_data,0,sizeof(decode_data));
-    r = fano(&metric,&cycles,decode_data,symbols,Nbits,mettab,delta,Maxcycles);
-    totcycles += cycles;
-    i = memcmp(data,decode_data,sizeof(data));
-    bad += (i != 0);
-    undetected += (r == 0 && i != 0);
-    good += (i == 0);
-
-    if(Verbose > 1 || (Verbose && r != 0)){
-      printf("trial %d fano returns %d, metric = %ld, cycles = %ld",trial,r,metric,cycles);
-      if(i != 0 && (Verbose > 1 || r == 0)){
-	// Error in data
-	putchar(' ');
-	for(i=0;i<Nbits/8;i++)
-	  printf("%02x",decode_data[i] ^ data[i]);
-      }
-      putchar('\n');
-    }
-  }
-  printf("trials %d avg cycles/bit %lg good %d bad %d undetected %d deletion rate %lg%%\n",
-	 trial,(double)totcycles/(trial*Nbits),good,bad,undetected,100.*bad/trial);
+  if(Ebn0_step <= 0)
+    Ebn0_step = 0.5;
+  Delta = delta * Scale;
+
+  job.nthreads = Nthreads;
+  job.trials = Trials;
+  job.max_frame_errors = Max_errors;
+  job.create = create_fanotest;
+  job.trial = fanotest_trial;
+  job.destroy = delete_fanotest;
+
+  printf("Code %s k=%d rate %.2f, Nbits = %d, Maxcycles/bit %ld, threads %d, seed %llu\n",
+	 Code->name,Code->k,Rate,Nbits,Maxcycles,Nthreads,job.seed);
+  for(ebn0 = Ebn0;ebn0 <= Ebn0_max + 1e-9 || ebn0 == Ebn0;ebn0 += Ebn0_step){
+    // Compute noise voltage. The factor of 2 accounts for BPSK seeing
+    // only half the noise power, and the sqrt() converts power to voltage
+    noise_amp = Signal / sqrt(2*Rate*pow(10.,ebn0/10.));
+    gen_met(Mettab,Signal,noise_amp,Rate,Scale);
+
+    // Generate channel transition matrix
+    setup_channel(Signal,noise_amp);
 
+    printf("Eb/N0 = %.3lf dB, Signal = %lg, Noise = %lg, BER@Eb/N0 = %lg, BER@Es/N0 = %lg\n",
+	   ebn0,Signal,noise_amp,0.5*erfc(pow(10.,ebn0/20.)),0.5*erfc(sqrt(Rate*pow(10.,ebn0/10.))));
 
+    if(mc_run(&job,&counts) != 0){
+      printf("simulation failed\n");
+      exit(1);
+    }
+    printf("trials %ld avg cycles/bit %lg good %ld bad %ld undetected %ld deletion rate %lg%% undetected BER %lg\n",
+	   counts.trials,(double)counts.cycles/counts.bits,counts.trials - counts.frame_errors,
+	   counts.frame_errors,counts.undetected,100.*counts.frame_errors/counts.trials,
+	   (double)counts.bit_errors/counts.bits);
+  }
   exit(0);
 }
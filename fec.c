@@ -3,6 +3,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include "fec.h"
 
 unsigned char Partab[256];
@@ -64,3 +65,98 @@ int Bitcnt[] = {
  5, 6, 6, 7, 6, 7, 7, 8,
 };
 
+
+/* Packed symbols: symbits (1-8) bits each, first symbol in the high bits
+ * of the first byte. 1-bit symbols are hard decisions.
+ * Unpacked, they span the full 0-255 range the decoders expect
+ */
+static unsigned char Unpack1[256][8];
+static unsigned char Unpack2[256][4];
+static unsigned char Unpack4[256][2];
+static unsigned char Scale3[8];
+static int U_init;
+
+static void unpack_init(void){
+  int i,j;
+
+  for(i=0;i<256;i++){
+    for(j=0;j<8;j++)
+      Unpack1[i][j] = (i & (0x80 >> j)) ? 255 : 0;
+    for(j=0;j<4;j++)
+      Unpack2[i][j] = 85 * ((i >> (6-2*j)) & 3);
+    for(j=0;j<2;j++)
+      Unpack4[i][j] = 17 * ((i >> (4-4*j)) & 15);
+  }
+  for(i=0;i<8;i++)
+    Scale3[i] = (255 * i + 3) / 7;
+  U_init = 1;
+}
+
+/* Expand nsyms packed symbols into one per byte. Returns -1 for a bad symbits */
+int unpack_syms(unsigned char *out,const unsigned char *in,int nsyms,int symbits){
+  unsigned long pos;
+  int i,v,max;
+
+  if(symbits < 1 || symbits > 8)
+    return -1;
+  if(!U_init)
+    unpack_init();
+
+  /* Whole bytes (or, for 3 bits, whole 3-byte groups) at a time */
+  switch(symbits){
+  case 1:
+    for(;nsyms >= 8;nsyms -= 8,out += 8)
+      memcpy(out,Unpack1[*in++],8);
+    break;
+  case 2:
+    for(;nsyms >= 4;nsyms -= 4,out += 4)
+      memcpy(out,Unpack2[*in++],4);
+    break;
+  case 3:
+    for(;nsyms >= 8;nsyms -= 8,in += 3){
+      unsigned long w = (in[0] << 16) | (in[1] << 8) | in[2];
+
+      for(i=21;i>=0;i -= 3)
+	*out++ = Scale3[(w >> i) & 7];
+    }
+    break;
+  case 4:
+    for(;nsyms >= 2;nsyms -= 2,out += 2)
+      memcpy(out,Unpack4[*in++],2);
+    break;
+  case 8:
+    memcpy(out,in,nsyms);
+    return 0;
+  }
+  /* Whatever's left, a bit at a time */
+  max = (1 << symbits) - 1;
+  for(pos=0;nsyms-- > 0;pos += symbits){
+    v = 0;
+    for(i=0;i<symbits;i++)
+      v = (v << 1) | ((in[(pos+i)/8] >> (7 - (pos+i)%8)) & 1);
+    *out++ = (255 * v + max/2) / max;
+  }
+  return 0;
+}
+
+/* Quantize nsyms 8-bit symbols to symbits each and pack them.
+ * Returns the number of bytes written, the last zero padded, or -1 for a bad symbits
+ */
+int pack_syms(unsigned char *out,const unsigned char *in,int nsyms,int symbits){
+  unsigned int acc = 0;
+  int nacc = 0,n = 0;
+
+  if(symbits < 1 || symbits > 8)
+    return -1;
+  while(nsyms-- > 0){
+    acc = (acc << symbits) | (*in++ >> (8 - symbits));
+    nacc += symbits;
+    if(nacc >= 8){
+      nacc -= 8;
+      out[n++] = acc >> nacc;
+    }
+  }
+  if(nacc > 0)
+    out[n++] = acc << (8 - nacc);
+  return n;
+}
@@ -10,16 +10,43 @@
 #define	V27POLYA	0x6d
 #define	V27POLYB	0x4f
 
+/* Puncturing of the r=1/2 codes to higher rates. Each of the period data
+ * bits has a flag for each of its two symbols, in the order they're
+ * generated, 1 if the symbol is sent and 0 if it's deleted
+ */
+#define MAXPUNCT 16
+struct puncture {
+  int period;
+  unsigned char keep[2*MAXPUNCT];
+};
+/* DVB-S puncturing patterns for the k=7 code. V27POLYA is the standard's
+ * G2 (133 octal, the Y symbol) and V27POLYB its G1 (171, X), so each
+ * pair here is Y then X
+ */
+extern const struct puncture V27punct23,V27punct34,V27punct56,V27punct78;
+
 void *create_viterbi27(int len);
 int init_viterbi27(void *vp,int starting_state);
 int update_viterbi27_blk(void *vp,unsigned char sym[],int npairs);
+int update_viterbi27_blk_packed(void *vp,const unsigned char *packed,int nbits,int symbits);
+int update_viterbi27_blk_punct(void *vp,const unsigned char *syms,int nbits,const struct puncture *pp);
 int chainback_viterbi27(void *vp, unsigned char *data,unsigned int nbits,unsigned int endstate);
 void delete_viterbi27(void *vp);
+int traceback_viterbi27(void *vp,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
+int tailbite_viterbi27(void *vp,unsigned char *data,unsigned char *syms,int nbits,int maxpasses);
+
+/* Streaming k=7 decoder with bounded delay and memory for unframed data */
+void *create_viterbi27_stream(int depth);
+int init_viterbi27_stream(void *vp,int starting_state);
+int update_viterbi27_stream(void *vp,unsigned char *syms,int nbits,unsigned char *data);
+int flush_viterbi27_stream(void *vp,unsigned char *data,int endstate);
+void delete_viterbi27_stream(void *vp);
 
 #ifdef __VEC__
 void *create_viterbi27_av(int len);
 int init_viterbi27_av(void *p,int starting_state);
 int chainback_viterbi27_av(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi27_av(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi27_av(void *p);
 int update_viterbi27_blk_av(void *p,unsigned char *syms,int nbits);
 #endif
@@ -28,28 +55,71 @@ int update_viterbi27_blk_av(void *p,unsigned char *syms,int nbits);
 void *create_viterbi27_mmx(int len);
 int init_viterbi27_mmx(void *p,int starting_state);
 int chainback_viterbi27_mmx(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi27_mmx(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi27_mmx(void *p);
 int update_viterbi27_blk_mmx(void *p,unsigned char *syms,int nbits);
 
 void *create_viterbi27_sse(int len);
 int init_viterbi27_sse(void *p,int starting_state);
 int chainback_viterbi27_sse(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi27_sse(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi27_sse(void *p);
 int update_viterbi27_blk_sse(void *p,unsigned char *syms,int nbits);
+#endif
 
+#if defined(__i386__) || defined(__x86_64__)
 void *create_viterbi27_sse2(int len);
 int init_viterbi27_sse2(void *p,int starting_state);
 int chainback_viterbi27_sse2(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi27_sse2(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi27_sse2(void *p);
 int update_viterbi27_blk_sse2(void *p,unsigned char *syms,int nbits);
+
+void *create_viterbi27_avx2(int len);
+int init_viterbi27_avx2(void *p,int starting_state);
+int chainback_viterbi27_avx2(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi27_avx2(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
+void delete_viterbi27_avx2(void *p);
+int update_viterbi27_blk_avx2(void *p,unsigned char *syms,int nbits);
 #endif
 
 void *create_viterbi27_port(int len);
 int init_viterbi27_port(void *p,int starting_state);
 int chainback_viterbi27_port(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi27_port(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi27_port(void *p);
 int update_viterbi27_blk_port(void *p,unsigned char *syms,int nbits);
 
+/* Decode many independent k=7 frames at once, one frame per SIMD lane.
+ * syms[i] points to frame i's symbols for the block; each frame has its
+ * own starting and ending state
+ */
+void *create_viterbi27_batch(int nframes,int len);
+int init_viterbi27_batch(void *vp,int starting_state[]);
+int update_viterbi27_batch(void *vp,unsigned char *syms[],int nbits);
+int chainback_viterbi27_batch(void *vp,int frame,unsigned char *data,unsigned int nbits,unsigned int endstate);
+void delete_viterbi27_batch(void *vp);
+
+#if defined(__i386__) || defined(__x86_64__)
+void *create_viterbi27_batch_sse2(int nframes,int len);
+int init_viterbi27_batch_sse2(void *p,int starting_state[]);
+int update_viterbi27_batch_sse2(void *p,unsigned char *syms[],int nbits);
+int chainback_viterbi27_batch_sse2(void *p,int frame,unsigned char *data,unsigned int nbits,unsigned int endstate);
+void delete_viterbi27_batch_sse2(void *p);
+
+void *create_viterbi27_batch_avx2(int nframes,int len);
+int init_viterbi27_batch_avx2(void *p,int starting_state[]);
+int update_viterbi27_batch_avx2(void *p,unsigned char *syms[],int nbits);
+int chainback_viterbi27_batch_avx2(void *p,int frame,unsigned char *data,unsigned int nbits,unsigned int endstate);
+void delete_viterbi27_batch_avx2(void *p);
+#endif
+
+void *create_viterbi27_batch_port(int nframes,int len);
+int init_viterbi27_batch_port(void *p,int starting_state[]);
+int update_viterbi27_batch_port(void *p,unsigned char *syms[],int nbits);
+int chainback_viterbi27_batch_port(void *p,int frame,unsigned char *data,unsigned int nbits,unsigned int endstate);
+void delete_viterbi27_batch_port(void *p);
+
 /* r=1/2 k=9 convolutional encoder polynomials */
 #define	V29POLYA	0x1af
 #define	V29POLYB	0x11d
@@ -57,13 +127,24 @@ int update_viterbi27_blk_port(void *p,unsigned char *syms,int nbits);
 void *create_viterbi29(int len);
 int init_viterbi29(void *vp,int starting_state);
 int update_viterbi29_blk(void *vp,unsigned char syms[],int nbits);
+int update_viterbi29_blk_packed(void *vp,const unsigned char *packed,int nbits,int symbits);
 int chainback_viterbi29(void *vp, unsigned char *data,unsigned int nbits,unsigned int endstate);
 void delete_viterbi29(void *vp);
+int traceback_viterbi29(void *vp,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
+int tailbite_viterbi29(void *vp,unsigned char *data,unsigned char *syms,int nbits,int maxpasses);
+
+/* Streaming k=9 decoder with bounded delay and memory for unframed data */
+void *create_viterbi29_stream(int depth);
+int init_viterbi29_stream(void *vp,int starting_state);
+int update_viterbi29_stream(void *vp,unsigned char *syms,int nbits,unsigned char *data);
+int flush_viterbi29_stream(void *vp,unsigned char *data,int endstate);
+void delete_viterbi29_stream(void *vp);
 
 #ifdef __VEC__
 void *create_viterbi29_av(int len);
 int init_viterbi29_av(void *p,int starting_state);
 int chainback_viterbi29_av(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi29_av(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi29_av(void *p);
 int update_viterbi29_blk_av(void *p,unsigned char *syms,int nbits);
 #endif
@@ -72,25 +153,38 @@ int update_viterbi29_blk_av(void *p,unsigned char *syms,int nbits);
 void *create_viterbi29_mmx(int len);
 int init_viterbi29_mmx(void *p,int starting_state);
 int chainback_viterbi29_mmx(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi29_mmx(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi29_mmx(void *p);
 int update_viterbi29_blk_mmx(void *p,unsigned char *syms,int nbits);
 
 void *create_viterbi29_sse(int len);
 int init_viterbi29_sse(void *p,int starting_state);
 int chainback_viterbi29_sse(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi29_sse(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi29_sse(void *p);
 int update_viterbi29_blk_sse(void *p,unsigned char *syms,int nbits);
+#endif
 
+#if defined(__i386__) || defined(__x86_64__)
 void *create_viterbi29_sse2(int len);
 int init_viterbi29_sse2(void *p,int starting_state);
 int chainback_viterbi29_sse2(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi29_sse2(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi29_sse2(void *p);
 int update_viterbi29_blk_sse2(void *p,unsigned char *syms,int nbits);
+
+void *create_viterbi29_avx2(int len);
+int init_viterbi29_avx2(void *p,int starting_state);
+int chainback_viterbi29_avx2(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi29_avx2(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
+void delete_viterbi29_avx2(void *p);
+int update_viterbi29_blk_avx2(void *p,unsigned char *syms,int nbits);
 #endif
 
 void *create_viterbi29_port(int len);
 int init_viterbi29_port(void *p,int starting_state);
 int chainback_viterbi29_port(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi29_port(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi29_port(void *p);
 int update_viterbi29_blk_port(void *p,unsigned char *syms,int nbits);
 
@@ -110,13 +204,23 @@ int update_viterbi29_blk_port(void *p,unsigned char *syms,int nbits);
 void *create_viterbi615(int len);
 int init_viterbi615(void *vp,int starting_state);
 int update_viterbi615_blk(void *vp,unsigned char *syms,int nbits);
+int update_viterbi615_blk_packed(void *vp,const unsigned char *packed,int nbits,int symbits);
 int chainback_viterbi615(void *vp, unsigned char *data,unsigned int nbits,unsigned int endstate);
 void delete_viterbi615(void *vp);
+int traceback_viterbi615(void *vp,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
+
+/* Streaming k=15 decoder with bounded delay and memory for unframed data */
+void *create_viterbi615_stream(int depth);
+int init_viterbi615_stream(void *vp,int starting_state);
+int update_viterbi615_stream(void *vp,unsigned char *syms,int nbits,unsigned char *data);
+int flush_viterbi615_stream(void *vp,unsigned char *data,int endstate);
+void delete_viterbi615_stream(void *vp);
 
 #ifdef __VEC__
 void *create_viterbi615_av(int len);
 int init_viterbi615_av(void *p,int starting_state);
 int chainback_viterbi615_av(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi615_av(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi615_av(void *p);
 int update_viterbi615_blk_av(void *p,unsigned char *syms,int nbits);
 #endif
@@ -125,29 +229,51 @@ int update_viterbi615_blk_av(void *p,unsigned char *syms,int nbits);
 void *create_viterbi615_mmx(int len);
 int init_viterbi615_mmx(void *p,int starting_state);
 int chainback_viterbi615_mmx(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi615_mmx(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi615_mmx(void *p);
 int update_viterbi615_blk_mmx(void *p,unsigned char *syms,int nbits);
 
 void *create_viterbi615_sse(int len);
 int init_viterbi615_sse(void *p,int starting_state);
 int chainback_viterbi615_sse(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi615_sse(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi615_sse(void *p);
 int update_viterbi615_blk_sse(void *p,unsigned char *syms,int nbits);
+#endif
 
+#if defined(__i386__) || defined(__x86_64__)
 void *create_viterbi615_sse2(int len);
 int init_viterbi615_sse2(void *p,int starting_state);
 int chainback_viterbi615_sse2(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi615_sse2(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi615_sse2(void *p);
 int update_viterbi615_blk_sse2(void *p,unsigned char *syms,int nbits);
-
 #endif
 
 void *create_viterbi615_port(int len);
 int init_viterbi615_port(void *p,int starting_state);
 int chainback_viterbi615_port(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+int traceback_viterbi615_port(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
 void delete_viterbi615_port(void *p);
 int update_viterbi615_blk_port(void *p,unsigned char *syms,int nbits);
 
+/* Table driven convolutional encoders, 8 data bits per step.
+ * polys[] use the Viterbi decoders' convention, newest bit in the LSB;
+ * bit p of flips inverts the symbols from polys[p]
+ */
+void *create_encoder(int k,int n,const unsigned long long polys[],unsigned int flips);
+void *create_encoder27(void);
+void *create_encoder29(void);
+void *create_encoder615(void);
+void init_encoder(void *p,unsigned long long state);
+/* One symbol per byte, 8*n per data byte */
+unsigned long long encode_conv(void *p,unsigned char *symbols,const unsigned char *data,int nbytes);
+/* Eight symbols per byte, first in the MSB; n bytes per data byte */
+unsigned long long encode_conv_packed(void *p,unsigned char *symbols,const unsigned char *data,int nbytes);
+void delete_encoder(void *p);
+/* Delete the symbols a puncturing pattern doesn't send; may be done in place */
+int puncture_syms(unsigned char *out,const unsigned char *in,int nbits,const struct puncture *pp);
+
 
 /* General purpose RS codec, 8-bit symbols */
 void encode_rs_char(void *rs,unsigned char *data,unsigned char *parity);
@@ -175,6 +301,19 @@ int decode_rs_8(unsigned char *data,int *eras_pos,int no_eras,int pad);
 void encode_rs_ccsds(unsigned char *data,unsigned char *parity,int pad);
 int decode_rs_ccsds(unsigned char *data,int *eras_pos,int no_eras,int pad);
 
+/* The same codes with depth (1-8) codewords interleaved symbol by symbol
+ * in a frame of depth*(255-pad) symbols, parity last, as in CCSDS transfer
+ * frames. Symbol j of codeword k is at frame[depth*j+k]. The encoders
+ * return -1 on bad parameters. The decoders correct in place and return the
+ * total number of corrected symbols, or -1 if any codeword couldn't be
+ * corrected; those are left unchanged. If results isn't NULL, results[k]
+ * gets the count for codeword k, or -1
+ */
+int encode_rs_8_il(unsigned char *frame,int depth,int pad);
+int decode_rs_8_il(unsigned char *frame,int depth,int pad,int results[]);
+int encode_rs_ccsds_il(unsigned char *frame,int depth,int pad);
+int decode_rs_ccsds_il(unsigned char *frame,int depth,int pad,int results[]);
+
 /* Tables to map from conventional->dual (Taltab) and
  * dual->conventional (Tal1tab) bases
  */
@@ -182,9 +321,26 @@ extern unsigned char Taltab[],Tal1tab[];
 
 
 /* CPU SIMD instruction set available */
-extern enum cpu_mode {UNKNOWN=0,PORT,MMX,SSE,SSE2,ALTIVEC} Cpu_mode;
+extern enum cpu_mode {UNKNOWN=0,PORT,MMX,SSE,SSE2,ALTIVEC,AVX2,SSSE3,SSE41,AVX512BW} Cpu_mode;
 void find_cpu_mode(void); /* Call this once at startup to set Cpu_mode */
 
+/* Every SIMD extension found by find_cpu_mode(), not just the one picked
+ * for Cpu_mode. Setting FEC_CPU_MODE in the environment to one of
+ * "port", "mmx", "sse", "sse2", "ssse3", "sse4.1", "avx2", "avx512bw"
+ * or "altivec" clears the bits above that level before Cpu_mode is chosen.
+ * CPU_PCLMUL isn't a level of its own; it's kept from "sse4.1" up
+ */
+extern unsigned int Cpu_features;
+#define CPU_MMX      (1<<0)
+#define CPU_SSE      (1<<1)
+#define CPU_SSE2     (1<<2)
+#define CPU_SSSE3    (1<<3)
+#define CPU_SSE41    (1<<4)
+#define CPU_AVX2     (1<<5)
+#define CPU_AVX512BW (1<<6)
+#define CPU_ALTIVEC  (1<<7)
+#define CPU_PCLMUL   (1<<8)
+
 /* Determine parity of argument: 1 = odd, 0 = even */
 #ifdef __i386__
 static inline int parityb(unsigned char x){
@@ -215,6 +371,13 @@ static inline int parity(int x){
 /* Useful utilities for simulation */
 double normal_rand(double mean, double std_dev);
 unsigned char addnoise(int sym,double amp,double gain,double offset,int clip);
+void *init_noise(double amp,double gain,double offset,int clip,unsigned long long seed);
+void addnoise_blk(void *np,unsigned char *out,const unsigned char *bits,int n);
+void free_noise(void *np);
+
+/* Packed symbols, symbits (1-8) bits each, first in the high bits of the first byte */
+int pack_syms(unsigned char *out,const unsigned char *in,int nsyms,int symbits);
+int unpack_syms(unsigned char *out,const unsigned char *in,int nsyms,int symbits);
 
 extern int Bitcnt[];
 
@@ -235,7 +398,9 @@ long dotprod_mmx(void *dp,signed short a[]);
 void *initdp_sse(signed short coeffs[],int len);
 void freedp_sse(void *dp);
 long dotprod_sse(void *dp,signed short a[]);
+#endif
 
+#if defined(__i386__) || defined(__x86_64__)
 void *initdp_sse2(signed short coeffs[],int len);
 void freedp_sse2(void *dp);
 long dotprod_sse2(void *dp,signed short a[]);
@@ -254,6 +419,8 @@ unsigned long long sumsq_port(signed short *in,int cnt);
 #ifdef __i386__
 unsigned long long sumsq_mmx(signed short *in,int cnt);
 unsigned long long sumsq_sse(signed short *in,int cnt);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
 unsigned long long sumsq_sse2(signed short *in,int cnt);
 #endif
 #ifdef __VEC__
@@ -5,6 +5,8 @@
 #include <math.h>
 #include <assert.h>
 #include <getopt.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 #include "viterbi224.h"
 #include "fano.h"
 #include "sim.h"
@@ -16,6 +18,9 @@ static inline int popcount(int x){
 struct option Options[] = {
   {"scale",1, NULL, 'S'},
   {"delta",1, NULL, 'd'},
+  {"threads",1, NULL, 'j'},
+  {"stack-nodes",1, NULL, 'p'},
+  {"seed",1, NULL, 'r'},
   {"max-cycles", 1, NULL, 'm'},
   {"frame-length",1,NULL,'l'},
   {"frame-count",1,NULL,'n'},
@@ -35,6 +40,9 @@ unsigned long Maxcycles = 1000;  // Maximum number of decoder moves per bit
 int Trials = 1000;               // Number of frames to test
 int Verbose;                     // diag diarrhea
 int Zerodata;                    // Use all 0's data (no effect on linear codes)
+int Nthreads = 1;                // Fano variants to race, each with its own delta
+int Stacknodes = 64;             // Stack decoder node pool, per bit of frame
+unsigned long long Seed;         // Frame n is generated from random stream n of this seed
 
 int main(int argc,char *argv[]){
   int mettab[2][256];
@@ -42,6 +50,7 @@ int main(int argc,char *argv[]){
   unsigned char xordata[Nbits/8];
   unsigned long cycles, metric;
   int delta = 4;
+  int deltas[16];
   time_t t;
   int trial,i,r;
   int errcnt;
@@ -55,14 +64,33 @@ int main(int argc,char *argv[]){
   int viterbi_bit_errors = 0;
   long totcycles = 0;
   long histogram[256];
+  int wins[16];
   double noise_amp; // Actual noise amplitude, computed from Signal amplitude & Eb/N0
   void *vp;
+  void *fp;
+  void *sp;
+  int stack_good_frames = 0;
+  int stack_failures = 0;
+  int stack_frame_errors = 0;
+  long stack_totcycles = 0;
+  double fano_time = 0,stack_time = 0; // CPU seconds, summed over all threads
+  struct rusage start,finish;
+  struct sim_rng rng;
 
-  while((i = getopt_long(argc,argv,"d:S:l:n:e:s:m:vz",Options,NULL)) != EOF){
+  while((i = getopt_long(argc,argv,"d:j:p:r:S:l:n:e:s:m:vz",Options,NULL)) != EOF){
     switch(i){
     case 'd':
       delta = atoi(optarg);
       break;
+    case 'j':
+      Nthreads = atoi(optarg);
+      break;
+    case 'r':
+      Seed = strtoull(optarg,NULL,0);
+      break;
+    case 'p':
+      Stacknodes = atoi(optarg);
+      break;
     case 'S':
       Scale = atoi(optarg);
       break;
@@ -88,7 +116,7 @@ int main(int argc,char *argv[]){
       Zerodata++;
       break;
     default:
-      printf("Usage: %s [-m maxcycles/bit] [-l bits/frame] [-n numframes] [-e Eb/No] [-s signal_amplitude] [-v] [-z]\n",
+      printf("Usage: %s [-d delta] [-j threads] [-p stack_nodes/bit] [-r seed] [-m maxcycles/bit] [-l bits/frame] [-n numframes] [-e Eb/No] [-s signal_amplitude] [-v] [-z]\n",
 	     argv[0]);
       exit(1);
       break;
@@ -98,7 +126,17 @@ int main(int argc,char *argv[]){
     printf("bits/frame must be >= 64\n");
     exit(1);
   }
+  if(Nthreads < 1 || Nthreads > 16){
+    printf("threads must be 1-16\n");
+    exit(1);
+  }
   delta *= Scale;
+  // With more than one thread, spread the deltas geometrically from delta/2 to 2*delta
+  for(i=0;i<Nthreads;i++){
+    deltas[i] = Nthreads == 1 ? delta : delta * pow(2.,2.*i/(Nthreads-1) - 1) + 0.5;
+    if(deltas[i] < 1)
+      deltas[i] = 1;
+  }
 
   // Compute noise voltage. The factor of 2 accounts for BPSK seeing
   // only half the noise power, and the sqrt() converts power to voltage
@@ -112,17 +150,36 @@ int main(int argc,char *argv[]){
   printf("Eb/N0 = %.3lf dB, Signal = %lg, Noise = %lg, BER@Eb/N0 = %lg, BER@Es/N0 = %lg\n",
 	 Ebn0,Signal,noise_amp,0.5*erfc(pow(10.,Ebn0/20.)),0.5*erfc(sqrt(Rate*pow(10.,Ebn0/10.))));
   
-  srandom(time(&t));
+  if(Seed == 0)
+    Seed = time(&t);
+  printf("Seed %llu\n",Seed);
+
+  if((fp = create_fano_mt(Nbits,NULL,Nthreads,deltas)) == NULL){
+    printf("create_fano_mt failed\n");
+    exit(1);
+  }
+  if((sp = create_stack(Nbits,Stacknodes*Nbits,NULL)) == NULL){
+    printf("create_stack failed\n");
+    exit(1);
+  }
+  if(Nthreads > 1){
+    printf("Fano deltas");
+    for(i=0;i<Nthreads;i++)
+      printf(" %d",deltas[i]);
+    putchar('\n');
+  }
 
   memset(histogram,0,sizeof(histogram));
+  memset(wins,0,sizeof(wins));
   memset(data,0,sizeof(data));
   for(trial = 0; trial < Trials; trial++){
-
+    // The frames are reproducible from the seed, one by one, as in the parallel simulations
+    sim_rng_init(&rng,Seed,trial);
     if(!Zerodata){
       // Generate random data
       // Note last 3 bytes must be 0 to tail off the encoder
       for(i=0;i<(Nbits-64)/8;i++)      // allow room on end for max length tail
-	data[i] = random() & 0xff;
+	data[i] = sim_rand64(&rng) & 0xff;
 
       for(;i<Nbits/8;i++)
 	data[i] = 0;
@@ -132,7 +189,7 @@ int main(int argc,char *argv[]){
     
     // Add noise & scale, build histogram
     for(i=0;i<2*Nbits;i++){
-      symbols[i] = simulate(symbols[i]);
+      symbols[i] = simulate_r(&rng,symbols[i]);
       histogram[symbols[i]]++;
     }
     if(Verbose > 2){
@@ -143,10 +200,32 @@ int main(int argc,char *argv[]){
 	  putchar('\n');
       }
     }
+    // Run the stack decoder on the same frame for comparison
+    getrusage(RUSAGE_SELF,&start);
+    r = stack_decode(sp,&metric,&cycles,decode_data,symbols,Nbits,mettab,delta,Maxcycles);
+    getrusage(RUSAGE_SELF,&finish);
+    stack_time += finish.ru_utime.tv_sec - start.ru_utime.tv_sec + 1e-6*(finish.ru_utime.tv_usec - start.ru_utime.tv_usec);
+    stack_totcycles += cycles;
+    if(r != 0){
+      ++stack_failures;
+      if(Verbose)
+	printf("trial %d stack: decode failure\n",trial);
+    } else if(memcmp(decode_data,data,sizeof(data)) != 0){
+      ++stack_frame_errors;
+      if(Verbose)
+	printf("trial %d stack: metric %ld, cycles %ld, frame error\n",trial,metric,cycles);
+    } else
+      ++stack_good_frames;
+
     memset(decode_data,0,sizeof(decode_data));
-    r = fano(&metric,&cycles,decode_data,symbols,Nbits,mettab,delta,Maxcycles);
+    getrusage(RUSAGE_SELF,&start);
+    r = fano_decode_mt(fp,&metric,&cycles,decode_data,symbols,Nbits,mettab,Maxcycles);
+    getrusage(RUSAGE_SELF,&finish);
+    fano_time += finish.ru_utime.tv_sec - start.ru_utime.tv_sec + 1e-6*(finish.ru_utime.tv_usec - start.ru_utime.tv_usec);
     totcycles += cycles;
-    if(r != 0){
+    if(r >= 0)
+      wins[r]++;
+    if(r < 0){
       ++fano_failures;
       if(Verbose)
 	printf("trial %d fano: decode failure\n",trial);
@@ -219,11 +298,22 @@ int main(int argc,char *argv[]){
   }
   printf("Fano good frames: %d, decode failures %d, frame errors %d, bit errors %d cycles/bit %lf\n",
 	 fano_good_frames,fano_failures,fano_frame_errors,fano_bit_errors,(double)totcycles/(trial*Nbits));
+  printf("Fano CPU time %.1lf us/frame\n",1e6*fano_time/trial);
+  printf("Stack good frames: %d, decode failures %d, frame errors %d, cycles/bit %lf, CPU time %.1lf us/frame\n",
+	 stack_good_frames,stack_failures,stack_frame_errors,(double)stack_totcycles/(trial*Nbits),1e6*stack_time/trial);
+  if(Nthreads > 1){
+    printf("Fano wins by delta:");
+    for(i=0;i<Nthreads;i++)
+      printf(" %d:%d",deltas[i],wins[i]);
+    putchar('\n');
+  }
   if(viterbi_attempts != 0){
     printf("Viterbi attempts %d good frames: %d frame errors %d (%lg%%) bit errors %d (%lg%%)\n",
 	   viterbi_attempts,
 	   viterbi_good_frames,viterbi_frame_errors,100.*viterbi_frame_errors/viterbi_attempts,
 	   viterbi_bit_errors,100.*viterbi_bit_errors/(Nbits*viterbi_attempts));
   }
+  delete_fano_mt(fp);
+  delete_stack(sp);
   exit(0);
 }
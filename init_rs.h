@@ -30,6 +30,7 @@
   rs->mm = symsize;
   rs->nn = (1<<symsize)-1;
   rs->pad = pad;
+  rs->gfpoly = gfpoly;
 
   rs->alpha_to = (data_t *)malloc(sizeof(data_t)*(rs->nn+1));
   if(rs->alpha_to == NULL){
@@ -44,6 +45,14 @@
     rs = NULL;
     goto done;
   }
+  rs->exp2 = (data_t *)malloc(sizeof(data_t)*2*rs->nn);
+  if(rs->exp2 == NULL){
+    free(rs->alpha_to);
+    free(rs->index_of);
+    free(rs);
+    rs = NULL;
+    goto done;
+  }
 
   /* Generate Galois field lookup tables */
   rs->index_of[0] = A0; /* log(zero) = -inf */
@@ -52,6 +61,7 @@
   for(i=0;i<rs->nn;i++){
     rs->index_of[sr] = i;
     rs->alpha_to[i] = sr;
+    rs->exp2[i] = rs->exp2[i+rs->nn] = sr;
     sr <<= 1;
     if(sr & (1<<symsize))
       sr ^= gfpoly;
@@ -61,6 +71,7 @@
     /* field generator polynomial is not primitive! */
     free(rs->alpha_to);
     free(rs->index_of);
+    free(rs->exp2);
     free(rs);
     rs = NULL;
     goto done;
@@ -71,6 +82,7 @@
   if(rs->genpoly == NULL){
     free(rs->alpha_to);
     free(rs->index_of);
+    free(rs->exp2);
     free(rs);
     rs = NULL;
     goto done;
@@ -7,13 +7,18 @@
 
 #include "char.h"
 #include "rs-common.h"
+#include "rs_syndrome.h"
+#include "rs_encode.h"
 
 void free_rs_char(void *p){
   struct rs *rs = (struct rs *)p;
 
   free(rs->alpha_to);
   free(rs->index_of);
+  free(rs->exp2);
   free(rs->genpoly);
+  free_rs_syndrome(rs->synd);
+  free_rs_encode(rs->enc);
   free(rs);
 }
 
@@ -31,5 +36,12 @@ void *init_rs_char(int symsize,int gfpoly,int fcr,int prim,
 
 #include "init_rs.h"
 
+  if(rs != NULL && (rs->synd = init_rs_syndrome(symsize,rs->alpha_to,rs->index_of,fcr,prim,nroots)) == NULL){
+    free_rs_char(rs);
+    rs = NULL;
+  }
+  /* Codes with more than 64 roots use the generic encoder */
+  if(rs != NULL)
+    rs->enc = init_rs_encode(symsize,rs->alpha_to,rs->index_of,rs->genpoly,nroots);
   return rs;
 }
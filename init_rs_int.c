@@ -5,6 +5,7 @@
  */
 #include <stdlib.h>
 
+#include "fec.h"
 #include "int.h"
 #include "rs-common.h"
 
@@ -13,7 +14,9 @@ void free_rs_int(void *p){
 
   free(rs->alpha_to);
   free(rs->index_of);
+  free(rs->exp2);
   free(rs->genpoly);
+  free(rs->mul);
   free(rs);
 }
 
@@ -31,5 +34,28 @@ void *init_rs_int(int symsize,int gfpoly,int fcr,int prim,
 
 #include "init_rs.h"
 
+  if(rs == NULL)
+    return NULL;
+  /* Pick the field arithmetic for the syndromes. Small fields get a full
+   * product table; the log tables stay the fallback
+   */
+  if(symsize <= 8){
+    int a,b;
+
+    if((rs->mul = malloc((rs->nn+1)*(rs->nn+1))) != NULL){
+      for(a=0;a<=rs->nn;a++)
+	for(b=0;b<=rs->nn;b++)
+	  rs->mul[(a << symsize) | b] = (a == 0 || b == 0) ? 0 :
+	    rs->exp2[rs->index_of[a] + rs->index_of[b]];
+      rs->field = RS_FIELD_TABLE;
+    }
+  }
+#if defined(__i386__) || defined(__x86_64__)
+  else if(symsize <= 16){
+    find_cpu_mode();
+    if(Cpu_features & CPU_PCLMUL)
+      rs->field = RS_FIELD_CLMUL;
+  }
+#endif
   return rs;
 }
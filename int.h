@@ -10,6 +10,7 @@ typedef unsigned int data_t;
 #define MM (rs->mm)
 #define NN (rs->nn)
 #define ALPHA_TO (rs->alpha_to) 
+#define ALPHA_TO2 (rs->exp2)
 #define INDEX_OF (rs->index_of)
 #define GENPOLY (rs->genpoly)
 #define NROOTS (rs->nroots)
@@ -0,0 +1,100 @@
+// Parallel Monte Carlo engine for bit and frame error rate simulations
+// Copyright 2026, Phil Karn, KA9Q
+// May be used under the terms of the GNU Lesser General Public License (LGPL)
+//
+// Error rates down around 1e-7 take billions of decoded bits, so the trials
+// are spread over a pool of threads, each with its own decoder. Trial n
+// draws all of its randomness from counter-based stream n (see sim.c), so a
+// given seed reproduces every frame exactly regardless of the thread count
+// or which thread happened to run it. Each thread keeps its own counts,
+// merged when the point is done.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "montecarlo.h"
+
+#define MC_BATCH 16 // Trials claimed at a time, to keep the shared counter cold
+
+struct mc_pool {
+  const struct mc_job *job;
+  long next;                 // Next unclaimed trial
+  long frame_errors;         // Running total, for stopping early
+  pthread_mutex_t lock;      // Protects the total
+  struct mc_counts total;
+  int failed;                // Some worker couldn't create its context
+};
+
+static void *mc_worker(void *arg){
+  struct mc_pool *pool = arg;
+  const struct mc_job *job = pool->job;
+  struct mc_counts counts;
+  struct sim_rng rng;
+  void *ctx;
+  long first,n,errors;
+
+  if((ctx = (*job->create)(job->arg)) == NULL){
+    __atomic_store_n(&pool->failed,1,__ATOMIC_RELAXED);
+    return NULL;
+  }
+  memset(&counts,0,sizeof(counts));
+  for(;;){
+    if(job->max_frame_errors > 0
+       && __atomic_load_n(&pool->frame_errors,__ATOMIC_RELAXED) >= job->max_frame_errors)
+      break;
+    if((first = __atomic_fetch_add(&pool->next,MC_BATCH,__ATOMIC_RELAXED)) >= job->trials)
+      break;
+    errors = counts.frame_errors;
+    for(n = first;n < first + MC_BATCH && n < job->trials;n++){
+      sim_rng_init(&rng,job->seed,n);
+      (*job->trial)(ctx,&rng,n,&counts);
+    }
+    if(counts.frame_errors != errors)
+      __atomic_fetch_add(&pool->frame_errors,counts.frame_errors - errors,__ATOMIC_RELAXED);
+  }
+  (*job->destroy)(ctx);
+
+  pthread_mutex_lock(&pool->lock);
+  pool->total.trials += counts.trials;
+  pool->total.bits += counts.bits;
+  pool->total.bit_errors += counts.bit_errors;
+  pool->total.frame_errors += counts.frame_errors;
+  pool->total.failures += counts.failures;
+  pool->total.undetected += counts.undetected;
+  pool->total.cycles += counts.cycles;
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+// Run one point's trials on job->nthreads threads and return the merged counts in total.
+// With max_frame_errors set, threads finish the batch they're on when the limit is hit,
+// so the trial count can go a little over what it would take in one thread.
+// Return 0, or -1 if a thread or a worker context couldn't be created
+int mc_run(const struct mc_job *job,struct mc_counts *total){
+  struct mc_pool pool;
+  pthread_t *threads;
+  int i,nthreads,r = 0;
+
+  memset(&pool,0,sizeof(pool));
+  pool.job = job;
+  pthread_mutex_init(&pool.lock,NULL);
+  nthreads = job->nthreads < 1 ? 1 : job->nthreads;
+  if((threads = malloc(nthreads * sizeof(*threads))) == NULL)
+    return -1;
+  for(i=0;i<nthreads;i++){
+    if(pthread_create(&threads[i],NULL,mc_worker,&pool) != 0){
+      fprintf(stderr,"mc_run: can't start worker %d\n",i);
+      r = -1;
+      break;
+    }
+  }
+  nthreads = i;
+  for(i=0;i<nthreads;i++)
+    pthread_join(threads[i],NULL);
+  free(threads);
+  pthread_mutex_destroy(&pool.lock);
+  if(pool.failed)
+    r = -1;
+  *total = pool.total;
+  return r;
+}
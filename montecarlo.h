@@ -0,0 +1,39 @@
+// Parallel Monte Carlo engine for bit and frame error rate simulations
+// Copyright 2026, Phil Karn, KA9Q
+// May be used under the terms of the GNU Lesser General Public License (LGPL)
+
+#ifndef _MONTECARLO_H_
+#define _MONTECARLO_H_
+
+#include "sim.h"
+
+// Outcome of a batch of trials; a trial adds its own frame to these
+struct mc_counts {
+  long trials;          // Frames simulated
+  long long bits;       // Data bits in those frames
+  long long bit_errors; // Data bits decoded wrong
+  long frame_errors;    // Frames with any bit decoded wrong
+  long failures;        // Frames the decoder gave up on (also counted as frame errors)
+  long undetected;      // Frames decoded wrong without the decoder noticing
+  long long cycles;     // Decoder effort, in whatever units it counts
+};
+
+// One Eb/N0 point's worth of trials
+struct mc_job {
+  int nthreads;               // Worker threads
+  long trials;                // Frames to simulate
+  long max_frame_errors;      // Stop early after this many frame errors, 0 for no limit
+  unsigned long long seed;    // Trial n draws only from stream n of this seed
+  void *arg;                  // Passed to create()
+
+  // Set up one worker's decoder and buffers; NULL on failure
+  void *(*create)(void *arg);
+  // Simulate one frame, drawing all randomness from rng, and add its outcome to counts
+  void (*trial)(void *ctx,struct sim_rng *rng,long trial,struct mc_counts *counts);
+  // Release what create() made
+  void (*destroy)(void *ctx);
+};
+
+int mc_run(const struct mc_job *job,struct mc_counts *total);
+
+#endif /* _MONTECARLO_H_ */
@@ -9,6 +9,8 @@ int peakval_port(signed short *b,int cnt);
 #ifdef __i386__
 int peakval_mmx(signed short *b,int cnt);
 int peakval_sse(signed short *b,int cnt);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
 int peakval_sse2(signed short *b,int cnt);
 #endif
 
@@ -28,7 +30,13 @@ int peakval(signed short *b,int cnt){
     return peakval_mmx(b,cnt);
   case SSE:
     return peakval_sse(b,cnt);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
   case SSE2:
+  case SSSE3:
+  case SSE41:
+  case AVX2:
+  case AVX512BW:
     return peakval_sse2(b,cnt);
 #endif
 #ifdef __VEC__
@@ -4,13 +4,38 @@
 #include <stdlib.h>
 #include "fec.h"
 
+#ifdef __x86_64__
+#include <emmintrin.h>
+
+/* peakval_sse2_assist.s is 32-bit code, so do the same thing with intrinsics.
+ * b must be 128-bit aligned; only the first cnt & ~7 words are examined
+ */
+static int peakval_sse2_assist(signed short *b,int cnt){
+  __m128i *bp = (__m128i *)b;
+  __m128i peak = _mm_setzero_si128();
+
+  while((cnt -= 8) >= 0){
+    __m128i x,sign;
+
+    x = *bp++;
+    sign = _mm_srai_epi16(x,15);    /* 1's if negative, 0's if positive */
+    x = _mm_sub_epi16(_mm_xor_si128(x,sign),sign); /* absolute value */
+    peak = _mm_max_epi16(peak,x);
+  }
+  peak = _mm_max_epi16(peak,_mm_srli_si128(peak,8));
+  peak = _mm_max_epi16(peak,_mm_srli_si128(peak,4));
+  peak = _mm_max_epi16(peak,_mm_srli_si128(peak,2));
+  return _mm_cvtsi128_si32(peak) & 0xffff;
+}
+#else
 int peakval_sse2_assist(signed short *,int);
+#endif
 
 int peakval_sse2(signed short *b,int cnt){
   int peak = 0;
   int a;
 
-  while(((int)b & 15) != 0 && cnt != 0){
+  while(((unsigned long)b & 15) != 0 && cnt != 0){
     a = abs(*b);
     if(a > peak)
       peak = a;
@@ -9,12 +9,25 @@ struct rs {
   int nn;              /* Symbols per block (= (1<<mm)-1) */
   data_t *alpha_to;     /* log lookup table */
   data_t *index_of;     /* Antilog lookup table */
+  data_t *exp2;         /* alpha_to over 0..2*nn-1, so a sum of two logs needs no modnn() */
   data_t *genpoly;      /* Generator polynomial */
   int nroots;     /* Number of generator roots = number of parity symbols */
   int fcr;        /* First consecutive root, index form */
   int prim;       /* Primitive element, index form */
   int iprim;      /* prim-th root of 1, index form */
   int pad;        /* Padding bytes in shortened block */
+  int gfpoly;     /* Field generator polynomial */
+  int field;      /* Field arithmetic for the syndromes, chosen at init (int only) */
+  unsigned char *mul; /* Product table, mul[a<<mm | b] = a*b (int, 8-bit symbols or less) */
+  void *synd;     /* Syndrome tables (8-bit symbols or less only) */
+  void *enc;      /* Encoder tables (8-bit symbols or less, up to 64 roots) */
+};
+
+/* Ways to multiply in the syndrome loop */
+enum rs_field {
+  RS_FIELD_LOG = 0,  /* Log and antilog tables */
+  RS_FIELD_TABLE,    /* Full product table */
+  RS_FIELD_CLMUL,    /* x86 carry-less multiply */
 };
 
 static inline int modnn(struct rs *rs,int x){
@@ -0,0 +1,29 @@
+/* Table driven Reed-Solomon encoding
+ * Switch to appropriate versions
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#include "fec.h"
+#include "rs_encode.h"
+
+void rs_encode(void *p,unsigned char *parity,const unsigned char *data,int len){
+  find_cpu_mode();
+
+  switch(Cpu_mode){
+  case PORT:
+  default:
+    rs_encode_port(p,parity,data,len);
+    return;
+#if defined(__i386__) || defined(__x86_64__)
+  case SSE2:
+  case SSSE3:
+  case SSE41:
+    rs_encode_sse2(p,parity,data,len);
+    return;
+  case AVX2:
+  case AVX512BW:
+    rs_encode_avx2(p,parity,data,len);
+    return;
+#endif
+  }
+}
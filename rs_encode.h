@@ -0,0 +1,40 @@
+/* Table driven Reed-Solomon encoding for codes with symbols of 8 bits or
+ * less and up to 64 roots
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ *
+ * Each step of the encoder's shift register XORs the feedback symbol times
+ * every generator coefficient into the register and shifts it one symbol.
+ * With a row of products for each of the 256 possible feedback values,
+ * that's one table row XORed into a shifted register, which the SIMD
+ * versions keep entirely in vector registers.
+ */
+#define RS_ENCODE_MAXROOTS 64
+
+struct rs_encode {
+  int nroots;
+  int stride;  /* Bytes per table row, a multiple of 32 */
+  /* Row f, byte k is f times the coefficient that goes into parity[k]; zero past nroots */
+  unsigned char tab[] __attribute__((aligned(32)));
+};
+
+/* Build the tables from the field's log tables and the generator polynomial
+ * in index form; NULL on failure or if the code is too big.
+ * The result is one block that may also be released with free()
+ */
+void *init_rs_encode(int symsize,const unsigned char *alpha_to,const unsigned char *index_of,
+		     const unsigned char *genpoly,int nroots);
+void free_rs_encode(void *p);
+
+/* Recompose the tables for symbols in another basis, given 256-entry maps
+ * to and from it; 0 on success, -1 if out of memory
+ */
+int rs_encode_basis(void *p,const unsigned char *to,const unsigned char *from);
+
+/* Compute the nroots parity symbols for len data symbols */
+void rs_encode(void *p,unsigned char *parity,const unsigned char *data,int len);
+void rs_encode_port(void *p,unsigned char *parity,const unsigned char *data,int len);
+#if defined(__i386__) || defined(__x86_64__)
+void rs_encode_sse2(void *p,unsigned char *parity,const unsigned char *data,int len);
+void rs_encode_avx2(void *p,unsigned char *parity,const unsigned char *data,int len);
+#endif
@@ -0,0 +1,55 @@
+/* Table driven Reed-Solomon encoding, x86 AVX2 version
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#include <string.h>
+#include <immintrin.h>
+#include "rs_encode.h"
+
+/* Bytes 1-32 of the 64-byte concatenation of lo and hi. VPALIGNR works
+ * within 128-bit lanes, so first line up the halves that straddle them
+ */
+static inline __m256i shift1(__m256i lo,__m256i hi){
+  return _mm256_alignr_epi8(_mm256_permute2x128_si256(lo,hi,0x21),lo,1);
+}
+
+/* The next feedback symbol is the data symbol, plus byte 1 of the register,
+ * plus byte 0 of the current row. Computing it that way in a scalar register
+ * takes the shift and the trip out of the vector unit off the critical path
+ */
+void rs_encode_avx2(void *p,unsigned char *parity,const unsigned char *data,int len){
+  struct rs_encode *sp = p;
+  __m256i r0,r1,zero,out[2];
+  const unsigned char *t;
+  int i,f,x;
+
+  zero = r0 = r1 = _mm256_setzero_si256();
+  if(len <= 0){
+    memset(parity,0,sp->nroots);
+    return;
+  }
+  f = data[0];
+  if(sp->stride == 32){
+    for(i=1;i<len;i++){
+      t = sp->tab + 32*f;
+      x = _mm256_cvtsi256_si32(r0) >> 8;
+      r0 = _mm256_xor_si256(shift1(r0,zero),_mm256_load_si256((const __m256i *)t));
+      f = (data[i] ^ x ^ t[0]) & 0xff;
+    }
+    r0 = _mm256_xor_si256(shift1(r0,zero),_mm256_load_si256((const __m256i *)(sp->tab + 32*f)));
+  } else {
+    for(i=1;i<len;i++){
+      t = sp->tab + 64*f;
+      x = _mm256_cvtsi256_si32(r0) >> 8;
+      r0 = _mm256_xor_si256(shift1(r0,r1),_mm256_load_si256((const __m256i *)t));
+      r1 = _mm256_xor_si256(shift1(r1,zero),_mm256_load_si256((const __m256i *)t+1));
+      f = (data[i] ^ x ^ t[0]) & 0xff;
+    }
+    t = sp->tab + 64*f;
+    r0 = _mm256_xor_si256(shift1(r0,r1),_mm256_load_si256((const __m256i *)t));
+    r1 = _mm256_xor_si256(shift1(r1,zero),_mm256_load_si256((const __m256i *)t+1));
+  }
+  _mm256_storeu_si256(out,r0);
+  _mm256_storeu_si256(out+1,r1);
+  memcpy(parity,out,sp->nroots);
+}
@@ -0,0 +1,80 @@
+/* Table driven Reed-Solomon encoding, table setup and portable C version
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#define _XOPEN_SOURCE 600
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "rs_encode.h"
+
+void *init_rs_encode(int symsize,const unsigned char *alpha_to,const unsigned char *index_of,
+		     const unsigned char *genpoly,int nroots){
+  struct rs_encode *sp;
+  void *p;
+  int nn,stride,f,k;
+
+  if(symsize < 1 || symsize > 8 || nroots < 1 || nroots > RS_ENCODE_MAXROOTS)
+    return NULL;
+  nn = (1 << symsize) - 1;
+  stride = (nroots + 31) & ~31;
+  if(posix_memalign(&p,32,sizeof(struct rs_encode) + 256*stride) != 0)
+    return NULL;
+  sp = p;
+  memset(sp,0,sizeof(struct rs_encode) + 256*stride);
+  sp->nroots = nroots;
+  sp->stride = stride;
+
+  /* Feedback values beyond the field can't occur with valid symbols; leave them zero */
+  for(f=1;f<=nn;f++)
+    for(k=0;k<nroots;k++)
+      if(genpoly[nroots-1-k] != nn) /* Zero coefficient */
+	sp->tab[f*stride + k] = alpha_to[(index_of[f] + genpoly[nroots-1-k]) % nn];
+  return sp;
+}
+
+/* Change the tables to work on symbols in another basis, e.g., the CCSDS dual
+ * basis, given the maps to it and from it. With feedback g in the new basis,
+ * row g becomes the old row from[g] mapped through to[], so the register and
+ * the parity stay in the new basis throughout
+ */
+int rs_encode_basis(void *p,const unsigned char *to,const unsigned char *from){
+  struct rs_encode *sp = p;
+  unsigned char *old;
+  int f,k;
+
+  if((old = malloc(256*sp->stride)) == NULL)
+    return -1;
+  memcpy(old,sp->tab,256*sp->stride);
+  for(f=0;f<256;f++)
+    for(k=0;k<sp->nroots;k++)
+      sp->tab[f*sp->stride + k] = to[old[from[f]*sp->stride + k]];
+  free(old);
+  return 0;
+}
+
+void free_rs_encode(void *p){
+  free(p);
+}
+
+/* Rather than shift the register, slide it along a buffer one symbol per step */
+void rs_encode_port(void *p,unsigned char *parity,const unsigned char *data,int len){
+  struct rs_encode *sp = p;
+  unsigned char buf[256 + RS_ENCODE_MAXROOTS];
+  const unsigned char *t;
+  uint64_t a,b;
+  int i,k,f;
+
+  memset(buf,0,len + sp->stride);
+  for(i=0;i<len;i++){
+    f = data[i] ^ buf[i];
+    t = sp->tab + f*sp->stride;
+    for(k=0;k<sp->stride;k+=8){
+      memcpy(&a,buf+i+1+k,8);
+      memcpy(&b,t+k,8);
+      a ^= b;
+      memcpy(buf+i+1+k,&a,8);
+    }
+  }
+  memcpy(parity,buf+len,sp->nroots);
+}
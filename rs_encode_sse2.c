@@ -0,0 +1,55 @@
+/* Table driven Reed-Solomon encoding, x86 SSE2 version
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#include <string.h>
+#include <emmintrin.h>
+#include "rs_encode.h"
+
+/* The register is nv XMM registers, parity[0] in the low byte of the first.
+ * Inlined with a constant nv so the register array stays in registers.
+ * As in the AVX2 version, the next feedback symbol comes from byte 1 of the
+ * register and byte 0 of the current row, off the vector critical path
+ */
+static inline __attribute__((always_inline))
+void encode(struct rs_encode *sp,unsigned char *parity,const unsigned char *data,int len,const int nv){
+  __m128i r[4],out[4];
+  const __m128i *t;
+  int i,k,f,x;
+
+  for(k=0;k<nv;k++)
+    r[k] = _mm_setzero_si128();
+  f = len > 0 ? data[0] : 0;
+  for(i=1;i<=len;i++){
+    t = (const __m128i *)(sp->tab + f*sp->stride);
+    x = _mm_cvtsi128_si32(r[0]) >> 8;
+    /* Shift down a byte and add in the feedback products */
+    for(k=0;k<nv-1;k++)
+      r[k] = _mm_xor_si128(_mm_or_si128(_mm_srli_si128(r[k],1),_mm_slli_si128(r[k+1],15)),_mm_load_si128(t+k));
+    r[nv-1] = _mm_xor_si128(_mm_srli_si128(r[nv-1],1),_mm_load_si128(t+nv-1));
+    if(i < len)
+      f = (data[i] ^ x ^ *(const unsigned char *)t) & 0xff;
+  }
+  for(k=0;k<nv;k++)
+    _mm_storeu_si128(out+k,r[k]);
+  memcpy(parity,out,sp->nroots);
+}
+
+void rs_encode_sse2(void *p,unsigned char *parity,const unsigned char *data,int len){
+  struct rs_encode *sp = p;
+
+  switch((sp->nroots + 15) >> 4){
+  case 1:
+    encode(sp,parity,data,len,1);
+    break;
+  case 2:
+    encode(sp,parity,data,len,2);
+    break;
+  case 3:
+    encode(sp,parity,data,len,3);
+    break;
+  default:
+    encode(sp,parity,data,len,4);
+    break;
+  }
+}
@@ -0,0 +1,92 @@
+/* Interleaved Reed-Solomon codewords, as in CCSDS transfer frames
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ *
+ * CCSDS interleaves I (255,223) codewords symbol by symbol, I = 1-5 or 8,
+ * so symbol j of codeword k is at frame[I*j+k]. These work on such frames
+ * in place. The decoders compute the syndromes of all I codewords together,
+ * and only a codeword with errors goes through Berlekamp-Massey, straight
+ * from those syndromes, writing just the corrected symbols in the frame.
+ */
+#include <string.h>
+#include "fec.h"
+#include "fixed.h"
+#include "rs_syndrome.h"
+
+#define MAXDEPTH 8
+
+static int encode_il(data_t *frame,int depth,int pad,int dual){
+  data_t cw[NN-NROOTS],parity[NROOTS];
+  int j,k,n = NN-NROOTS-pad;
+
+  if(depth < 1 || depth > MAXDEPTH || pad < 0 || pad > 222)
+    return -1;
+  for(k=0;k<depth;k++){
+    for(j=0;j<n;j++)
+      cw[j] = frame[depth*j+k];
+    if(dual)
+      encode_rs_ccsds(cw,parity,pad);
+    else
+      encode_rs_8(cw,parity,pad);
+    for(j=0;j<NROOTS;j++)
+      frame[depth*(n+j)+k] = parity[j];
+  }
+  return 0;
+}
+
+#define SYNDROME(s,data,len) memcpy(s,synd,NROOTS)
+#define CORRECTION(x) (dual ? Taltab[x] : (x))
+#define STRIDE depth
+
+/* Correct the codeword at data, its symbols depth apart, given its syndromes */
+static int correct_il(data_t *data,int depth,const data_t *synd,int pad,int dual){
+  int *eras_pos = NULL;
+  int no_eras = 0;
+  int retval;
+
+#include "decode_rs.h"
+
+  return retval;
+}
+
+static int decode_il(data_t *frame,int depth,int pad,int results[],int dual){
+  data_t s[MAXDEPTH*NROOTS];
+  const unsigned char *conv = NULL;
+  void *sp;
+  int k,r,mask,total = 0;
+
+  if(depth < 1 || depth > MAXDEPTH || pad < 0 || pad > 222 || (sp = syndrome_rs_8()) == NULL)
+    return -1;
+  if(dual && (conv = dual_conv_rs_8()) == NULL)
+    return -1;
+
+  mask = rs_syndrome_il(sp,s,frame,NN-pad,depth,conv);
+  for(k=0;k<depth;k++){
+    r = 0;
+    if(mask & (1 << k))
+      r = correct_il(frame+k,depth,s+k*NROOTS,pad,dual);
+    if(results != NULL)
+      results[k] = r;
+    if(r < 0)
+      total = -1;
+    else if(total >= 0)
+      total += r;
+  }
+  return total;
+}
+
+int encode_rs_8_il(unsigned char *frame,int depth,int pad){
+  return encode_il(frame,depth,pad,0);
+}
+
+int decode_rs_8_il(unsigned char *frame,int depth,int pad,int results[]){
+  return decode_il(frame,depth,pad,results,0);
+}
+
+int encode_rs_ccsds_il(unsigned char *frame,int depth,int pad){
+  return encode_il(frame,depth,pad,1);
+}
+
+int decode_rs_ccsds_il(unsigned char *frame,int depth,int pad,int results[]){
+  return decode_il(frame,depth,pad,results,1);
+}
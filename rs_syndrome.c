@@ -0,0 +1,43 @@
+/* Reed-Solomon syndrome evaluation
+ * Switch to appropriate versions
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#include "fec.h"
+#include "rs_syndrome.h"
+
+int rs_syndrome(void *p,unsigned char *s,const unsigned char *data,int len){
+  find_cpu_mode();
+
+  switch(Cpu_mode){
+  case PORT:
+  default:
+    return rs_syndrome_port(p,s,data,len);
+#if defined(__i386__) || defined(__x86_64__)
+  case SSSE3:
+  case SSE41:
+    return rs_syndrome_ssse3(p,s,data,len);
+  case AVX2:
+  case AVX512BW:
+    return rs_syndrome_avx2(p,s,data,len);
+#endif
+  }
+}
+
+int rs_syndrome_il(void *p,unsigned char *s,const unsigned char *data,int len,int depth,const unsigned char *conv){
+  find_cpu_mode();
+
+  switch(Cpu_mode){
+  case PORT:
+  default:
+    return rs_syndrome_il_port(p,s,data,len,depth,conv);
+#if defined(__i386__) || defined(__x86_64__)
+  case SSSE3:
+  case SSE41:
+    return rs_syndrome_il_ssse3(p,s,data,len,depth,conv);
+  case AVX2:
+  case AVX512BW:
+    return rs_syndrome_il_avx2(p,s,data,len,depth,conv);
+#endif
+  }
+}
@@ -0,0 +1,67 @@
+/* Reed-Solomon syndrome evaluation with split-nibble GF multiplies,
+ * for codes with symbols of 8 bits or less
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ *
+ * Multiplying by a constant is linear over GF(2), so the product of a byte
+ * is the XOR of the products of its two nibbles, each a lookup in a 16-entry
+ * table. A 16-entry table is exactly what PSHUFB indexes, so one shuffle per
+ * nibble multiplies a whole register of symbols by the same constant.
+ *
+ * To get the same constant in every lane, each root b is evaluated as a
+ * W-way interleaved Horner's rule with multiplier b^W (W = 16 for SSSE3,
+ * 32 for AVX2), then the lanes are folded in half W/2, W/4, ... 1 times,
+ * multiplying the upper halves by b^(W/2), b^(W/4), ... b.
+ */
+#define SYN_POWERS 6 /* Multipliers b^32, b^16, b^8, b^4, b^2 and b of each root */
+
+struct rs_syndrome {
+  int nroots;
+  int nroots4;  /* Rounded up to a multiple of 4; the extra roots have all-zero tables */
+  /* Products of the low nibbles in [0..15], of the high nibbles in [16..31] */
+  unsigned char tab[][SYN_POWERS][32] __attribute__((aligned(32)));
+};
+
+/* Build the tables from the field's log tables; NULL on failure.
+ * The result is one block that may also be released with free()
+ */
+void *init_rs_syndrome(int symsize,const unsigned char *alpha_to,const unsigned char *index_of,
+		       int fcr,int prim,int nroots);
+void free_rs_syndrome(void *p);
+
+/* Evaluate the len symbols of data at every root, writing the syndromes
+ * in polynomial form to s[0..nroots-1]. Returns nonzero if any is nonzero
+ */
+int rs_syndrome(void *p,unsigned char *s,const unsigned char *data,int len);
+int rs_syndrome_port(void *p,unsigned char *s,const unsigned char *data,int len);
+#if defined(__i386__) || defined(__x86_64__)
+int rs_syndrome_ssse3(void *p,unsigned char *s,const unsigned char *data,int len);
+int rs_syndrome_avx2(void *p,unsigned char *s,const unsigned char *data,int len);
+#endif
+
+/* The same for depth codewords of len symbols interleaved symbol by symbol,
+ * symbol j of codeword k at data[depth*j+k], depth 1-8. Syndrome i of
+ * codeword k goes to s[k*nroots+i]. If conv isn't NULL, each symbol first
+ * goes through the linear map with those nibble tables, e.g., from the
+ * CCSDS dual basis. Returns a mask of the codewords with nonzero syndromes
+ */
+int rs_syndrome_il(void *p,unsigned char *s,const unsigned char *data,int len,int depth,const unsigned char *conv);
+int rs_syndrome_il_port(void *p,unsigned char *s,const unsigned char *data,int len,int depth,const unsigned char *conv);
+#if defined(__i386__) || defined(__x86_64__)
+int rs_syndrome_il_ssse3(void *p,unsigned char *s,const unsigned char *data,int len,int depth,const unsigned char *conv);
+int rs_syndrome_il_avx2(void *p,unsigned char *s,const unsigned char *data,int len,int depth,const unsigned char *conv);
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
+/* Syndromes of the general int codec for symbols of 9-16 bits by carry-less
+ * multiplication, given the roots in polynomial form and the field polynomial
+ */
+void rs_syndrome_clmul(unsigned int *s,const unsigned int *data,int len,
+		       const unsigned int *roots,int nroots,int symsize,unsigned int gfpoly);
+#endif
+
+/* Tables for the fixed CCSDS code of decode_rs_8(), and the conv tables
+ * for its symbols in the CCSDS dual basis, built on first use
+ */
+void *syndrome_rs_8(void);
+const unsigned char *dual_conv_rs_8(void);
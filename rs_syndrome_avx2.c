@@ -0,0 +1,180 @@
+/* Reed-Solomon syndrome evaluation, x86 AVX2 version
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#include <string.h>
+#include <immintrin.h>
+#include "rs_syndrome.h"
+
+/* Multiply 32 symbols by the constant whose nibble tables are at t.
+ * VPSHUFB looks up within each 128-bit half, so both halves get the tables
+ */
+static inline __m256i gfmul256(__m256i x,const unsigned char *t){
+  __m256i mask = _mm256_set1_epi8(0x0f);
+  __m256i lo = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_load_si128((__m128i *)t)),_mm256_and_si256(x,mask));
+  __m256i hi = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_load_si128((__m128i *)(t+16))),
+				   _mm256_and_si256(_mm256_srli_epi16(x,4),mask));
+
+  return _mm256_xor_si256(lo,hi);
+}
+
+static inline __m128i gfmul(__m128i x,const unsigned char *t){
+  __m128i mask = _mm_set1_epi8(0x0f);
+  __m128i lo = _mm_shuffle_epi8(_mm_load_si128((__m128i *)t),_mm_and_si128(x,mask));
+  __m128i hi = _mm_shuffle_epi8(_mm_load_si128((__m128i *)(t+16)),_mm_and_si128(_mm_srli_epi16(x,4),mask));
+
+  return _mm_xor_si128(lo,hi);
+}
+
+int rs_syndrome_avx2(void *p,unsigned char *s,const unsigned char *data,int len){
+  struct rs_syndrome *sp = p;
+  unsigned char first[32];
+  __m256i acc[4],d,head;
+  __m128i a;
+  int i,j,k,err = 0;
+  int nblocks = len >> 5;
+  int extra = len & 31;
+
+  /* Leading zeros don't change the value of a polynomial, so pad
+   * the front of the block out to a whole number of registers
+   */
+  memset(first,0,sizeof(first));
+  memcpy(first+32-extra,data,extra);
+  head = _mm256_loadu_si256((__m256i *)first);
+  data += extra;
+
+  /* Four roots at a time to keep the shuffle unit busy */
+  for(i=0;i<sp->nroots4;i+=4){
+    for(k=0;k<4;k++)
+      acc[k] = head;
+    for(j=0;j<nblocks;j++){
+      d = _mm256_loadu_si256((__m256i *)(data + 32*j));
+      for(k=0;k<4;k++)
+	acc[k] = _mm256_xor_si256(gfmul256(acc[k],sp->tab[i+k][0]),d);
+    }
+    for(k=0;k<4;k++){
+      /* Lane r carries weight b^(31-r); fold down to lane 0 */
+      a = _mm_xor_si128(_mm256_castsi256_si128(gfmul256(acc[k],sp->tab[i+k][1])),
+			_mm256_extracti128_si256(acc[k],1));
+      a = _mm_xor_si128(gfmul(a,sp->tab[i+k][2]),_mm_srli_si128(a,8));
+      a = _mm_xor_si128(gfmul(a,sp->tab[i+k][3]),_mm_srli_si128(a,4));
+      a = _mm_xor_si128(gfmul(a,sp->tab[i+k][4]),_mm_srli_si128(a,2));
+      a = _mm_xor_si128(gfmul(a,sp->tab[i+k][5]),_mm_srli_si128(a,1));
+      if(i+k < sp->nroots){
+	s[i+k] = _mm_cvtsi128_si32(a);
+	err |= s[i+k];
+      }
+    }
+  }
+  return err;
+}
+
+/* Interleaved codewords, as in the SSSE3 version but with 32 lanes */
+
+/* Apply the linear map with nibble tables clo and chi to 32 symbols */
+static inline __m256i convert256(__m256i x,__m256i clo,__m256i chi){
+  __m256i mask = _mm256_set1_epi8(0x0f);
+
+  return _mm256_xor_si256(_mm256_shuffle_epi8(clo,_mm256_and_si256(x,mask)),
+			  _mm256_shuffle_epi8(chi,_mm256_and_si256(_mm256_srli_epi16(x,4),mask)));
+}
+
+/* Byte shifts by a variable count n (0-16), as shuffles: bytes n..n+15 of
+ * a register followed by zeros, or of zeros followed by a register
+ */
+static const unsigned char Shift_idx[48] = {
+  0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,
+  0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,
+  0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,
+};
+
+static inline __m128i shr(__m128i x,int n){
+  return _mm_shuffle_epi8(x,_mm_loadu_si128((__m128i *)(Shift_idx+16+n)));
+}
+
+static inline __m128i shl(__m128i x,int n){
+  return _mm_shuffle_epi8(x,_mm_loadu_si128((__m128i *)(Shift_idx+16-n)));
+}
+
+/* Fold the m lane groups of depth lanes down to one, codeword c in lane c.
+ * The first fold brings the upper groups across the 128-bit halves
+ */
+static inline __m128i fold(__m256i acc,struct rs_syndrome *sp,int root,int m,int depth){
+  __m128i a;
+  int n;
+
+  m >>= 1;
+  n = m*depth; /* 16 or less */
+  a = _mm_xor_si128(_mm256_castsi256_si128(gfmul256(acc,sp->tab[root][SYN_POWERS-1-__builtin_ctz(m)])),
+		    _mm_or_si128(shr(_mm256_castsi256_si128(acc),n),shl(_mm256_extracti128_si256(acc,1),16-n)));
+  while(m > 1){
+    m >>= 1;
+    a = _mm_xor_si128(gfmul(a,sp->tab[root][SYN_POWERS-1-__builtin_ctz(m)]),shr(a,m*depth));
+  }
+  return a;
+}
+
+int rs_syndrome_il_avx2(void *p,unsigned char *s,const unsigned char *data,int len,int depth,const unsigned char *conv){
+  struct rs_syndrome *sp = p;
+  unsigned char first[32],last[32],lanes[4][16];
+  __m256i acc[4],tlo[4],thi[4],d,head,tail,clo,chi;
+  int m,pw,L,extra,nblocks,nsafe,i,j,k,c,mask = 0;
+
+  if(depth == 1)
+    m = 32,pw = 0;
+  else if(depth == 2)
+    m = 16,pw = 1;
+  else if(depth <= 4)
+    m = 8,pw = 2;
+  else
+    m = 4,pw = 3;
+  L = depth * m; /* Bytes per block; the rest of the register is ignored */
+  extra = len % m;
+  nblocks = len / m;
+
+  memset(first,0,sizeof(first));
+  memcpy(first + (m-extra)*depth,data,extra*depth);
+  data += extra*depth;
+  /* Don't read past the end of the frame; at most one block is too close */
+  nsafe = nblocks;
+  if(L < 32 && nsafe > 0 && (nsafe-1)*L + 32 > nblocks*L)
+    nsafe--;
+  memset(last,0,sizeof(last));
+  if(nsafe < nblocks)
+    memcpy(last,data + nsafe*L,L);
+
+  /* With no conversion, use the identity map rather than test for it in the loop */
+  clo = _mm256_setr_epi8(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
+  chi = _mm256_slli_epi16(clo,4);
+  if(conv != NULL){
+    clo = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)conv));
+    chi = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)(conv+16)));
+  }
+  head = convert256(_mm256_loadu_si256((__m256i *)first),clo,chi);
+  tail = convert256(_mm256_loadu_si256((__m256i *)last),clo,chi);
+  for(i=0;i<sp->nroots4;i+=4){
+    for(k=0;k<4;k++){
+      acc[k] = head;
+      tlo[k] = _mm256_broadcastsi128_si256(_mm_load_si128((__m128i *)sp->tab[i+k][pw]));
+      thi[k] = _mm256_broadcastsi128_si256(_mm_load_si128((__m128i *)(sp->tab[i+k][pw]+16)));
+    }
+    for(j=0;j<nsafe;j++){
+      d = convert256(_mm256_loadu_si256((__m256i *)(data + j*L)),clo,chi);
+      for(k=0;k<4;k++)
+	acc[k] = _mm256_xor_si256(convert256(acc[k],tlo[k],thi[k]),d);
+    }
+    if(nsafe < nblocks){
+      for(k=0;k<4;k++)
+	acc[k] = _mm256_xor_si256(convert256(acc[k],tlo[k],thi[k]),tail);
+    }
+    for(k=0;k<4 && i+k < sp->nroots;k++){
+      _mm_storeu_si128((__m128i *)lanes[k],fold(acc[k],sp,i+k,m,depth));
+      for(c=0;c<depth;c++){
+	s[c*sp->nroots + i+k] = lanes[k][c];
+	if(lanes[k][c] != 0)
+	  mask |= 1 << c;
+      }
+    }
+  }
+  return mask;
+}
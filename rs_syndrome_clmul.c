@@ -0,0 +1,81 @@
+/* Reed-Solomon syndrome evaluation for symbols of 9-16 bits, x86 PCLMULQDQ version
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ *
+ * Log tables for 16-bit symbols fill much of the L2 cache, so these multiply
+ * with carry-less multiplication instead, reducing modulo the field polynomial
+ * with Barrett's method. Each step takes two symbols: with s in bits 32-63
+ * and the next symbol d in bits 0-31, one multiply by b^2 + b*x^32 leaves
+ * s*b^2 + d*b in bits 32-62, as none of the partial products is over 31 bits.
+ * That's three multiplies per two symbols per root.
+ */
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#include "rs_syndrome.h"
+
+/* Product of a and b in the field of the given size and polynomial, the slow way */
+static unsigned int gfmul(unsigned int a,unsigned int b,int symsize,unsigned int gfpoly){
+  unsigned int p = 0;
+
+  while(b != 0){
+    if(b & 1)
+      p ^= a;
+    b >>= 1;
+    a <<= 1;
+    if(a & (1 << symsize))
+      a ^= gfpoly;
+  }
+  return p;
+}
+
+/* x^(2*symsize) divided by the field polynomial, for the Barrett reduction */
+static unsigned int barrett_mu(int symsize,unsigned int gfpoly){
+  unsigned long long r = 1ULL << (2*symsize);
+  unsigned int q = 0;
+  int i;
+
+  for(i=2*symsize;i>=symsize;i--){
+    if(r & (1ULL << i)){
+      r ^= (unsigned long long)gfpoly << (i-symsize);
+      q |= 1 << (i-symsize);
+    }
+  }
+  return q;
+}
+
+void rs_syndrome_clmul(unsigned int *s,const unsigned int *data,int len,
+		       const unsigned int *roots,int nroots,int symsize,unsigned int gfpoly){
+  __m128i b[nroots],acc[nroots];
+  __m128i mu = _mm_cvtsi32_si128(barrett_mu(symsize,gfpoly));
+  __m128i poly = _mm_cvtsi32_si128(gfpoly);
+  __m128i mask = _mm_cvtsi32_si128((1 << symsize) - 1);
+  __m128i shift = _mm_cvtsi32_si128(symsize);
+  int i,j = 0;
+
+  for(i=0;i<nroots;i++){
+    b[i] = _mm_set_epi32(0,0,roots[i],gfmul(roots[i],roots[i],symsize,gfpoly));
+    acc[i] = _mm_setzero_si128();
+  }
+  /* Take an odd symbol first so the rest go in pairs */
+  if(len & 1){
+    for(i=0;i<nroots;i++)
+      acc[i] = _mm_cvtsi32_si128(data[0]);
+    j = 1;
+  }
+  for(;j<len;j+=2){
+    __m128i d0 = _mm_cvtsi32_si128(data[j]);
+    __m128i d1 = _mm_cvtsi32_si128(data[j+1]);
+
+    for(i=0;i<nroots;i++){
+      __m128i c,q;
+
+      c = _mm_clmulepi64_si128(_mm_unpacklo_epi32(d0,acc[i]),b[i],0x00);
+      c = _mm_srli_epi64(c,32);
+      q = _mm_clmulepi64_si128(_mm_srl_epi64(c,shift),mu,0x00);
+      q = _mm_clmulepi64_si128(_mm_srl_epi64(q,shift),poly,0x00);
+      acc[i] = _mm_xor_si128(_mm_and_si128(_mm_xor_si128(c,q),mask),d1);
+    }
+  }
+  for(i=0;i<nroots;i++)
+    s[i] = _mm_cvtsi128_si32(acc[i]);
+}
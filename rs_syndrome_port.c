@@ -0,0 +1,106 @@
+/* Reed-Solomon syndrome evaluation, table setup and portable C version
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#define _XOPEN_SOURCE 600
+#include <stdlib.h>
+#include <string.h>
+#include "rs_syndrome.h"
+
+/* Tables for symsize-bit symbols and the roots alpha^((fcr+i)*prim), i = 0..nroots-1 */
+void *init_rs_syndrome(int symsize,const unsigned char *alpha_to,const unsigned char *index_of,
+		       int fcr,int prim,int nroots){
+  struct rs_syndrome *sp;
+  void *p;
+  int nn,nroots4,i,k,b,x,e;
+  unsigned char bitprod[8];
+
+  if(symsize < 1 || symsize > 8 || nroots < 0)
+    return NULL;
+  nn = (1 << symsize) - 1;
+  nroots4 = (nroots + 3) & ~3;
+  if(posix_memalign(&p,32,sizeof(struct rs_syndrome) + nroots4*sizeof(sp->tab[0])) != 0)
+    return NULL;
+  sp = p;
+  memset(sp,0,sizeof(struct rs_syndrome) + nroots4*sizeof(sp->tab[0]));
+  sp->nroots = nroots;
+  sp->nroots4 = nroots4;
+
+  for(i=0;i<nroots;i++){
+    for(k=0;k<SYN_POWERS;k++){
+      /* Multiplier is b^(2^(5-k)), b = alpha^((fcr+i)*prim) */
+      e = (int)(((long)(fcr+i) * prim * (32 >> k)) % nn);
+
+      /* Products of the basis bits; bits beyond the symbol contribute nothing */
+      for(b=0;b<8;b++)
+	bitprod[b] = b < symsize ? alpha_to[(index_of[1 << b] + e) % nn] : 0;
+      for(x=0;x<16;x++){
+	sp->tab[i][k][x] = sp->tab[i][k][16+x] = 0;
+	for(b=0;b<4;b++){
+	  if(x & (1 << b)){
+	    sp->tab[i][k][x] ^= bitprod[b];
+	    sp->tab[i][k][16+x] ^= bitprod[b+4];
+	  }
+	}
+      }
+    }
+  }
+  return sp;
+}
+
+void free_rs_syndrome(void *p){
+  free(p);
+}
+
+/* One symbol at a time, but with two nibble lookups in place of a
+ * log, a modular add and an antilog per root
+ */
+int rs_syndrome_port(void *p,unsigned char *s,const unsigned char *data,int len){
+  struct rs_syndrome *sp = p;
+  const unsigned char *t;
+  int i,j,x,err = 0;
+
+  for(i=0;i<sp->nroots;i++)
+    s[i] = data[0];
+  /* Roots innermost, so their lookups overlap */
+  for(j=1;j<len;j++){
+    for(i=0;i<sp->nroots;i++){
+      t = sp->tab[i][SYN_POWERS-1];
+      x = s[i];
+      s[i] = t[x & 15] ^ t[16 + (x >> 4)] ^ data[j];
+    }
+  }
+  for(i=0;i<sp->nroots;i++)
+    err |= s[i];
+  return err;
+}
+
+int rs_syndrome_il_port(void *p,unsigned char *s,const unsigned char *data,int len,int depth,const unsigned char *conv){
+  struct rs_syndrome *sp = p;
+  unsigned char *sk;
+  const unsigned char *t;
+  int i,j,k,x,d,err,mask = 0;
+
+  for(k=0;k<depth;k++){
+    sk = s + k*sp->nroots;
+    for(i=0;i<sp->nroots;i++)
+      sk[i] = 0;
+    /* As in rs_syndrome_port(), with each symbol converted once */
+    for(j=0;j<len;j++){
+      d = data[depth*j+k];
+      if(conv != NULL)
+	d = conv[d & 15] ^ conv[16 + (d >> 4)];
+      for(i=0;i<sp->nroots;i++){
+	t = sp->tab[i][SYN_POWERS-1];
+	x = sk[i];
+	sk[i] = t[x & 15] ^ t[16 + (x >> 4)] ^ d;
+      }
+    }
+    err = 0;
+    for(i=0;i<sp->nroots;i++)
+      err |= sk[i];
+    if(err != 0)
+      mask |= 1 << k;
+  }
+  return mask;
+}
@@ -0,0 +1,156 @@
+/* Reed-Solomon syndrome evaluation, x86 SSSE3 version
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#include <string.h>
+#include <tmmintrin.h>
+#include "rs_syndrome.h"
+
+/* Multiply 16 symbols by the constant whose nibble tables are at t */
+static inline __m128i gfmul(__m128i x,const unsigned char *t){
+  __m128i mask = _mm_set1_epi8(0x0f);
+  __m128i lo = _mm_shuffle_epi8(_mm_load_si128((__m128i *)t),_mm_and_si128(x,mask));
+  __m128i hi = _mm_shuffle_epi8(_mm_load_si128((__m128i *)(t+16)),_mm_and_si128(_mm_srli_epi16(x,4),mask));
+
+  return _mm_xor_si128(lo,hi);
+}
+
+int rs_syndrome_ssse3(void *p,unsigned char *s,const unsigned char *data,int len){
+  struct rs_syndrome *sp = p;
+  unsigned char first[16];
+  __m128i acc[4],d,head;
+  int i,j,k,err = 0;
+  int nblocks = len >> 4;
+  int extra = len & 15;
+
+  /* Leading zeros don't change the value of a polynomial, so pad
+   * the front of the block out to a whole number of registers
+   */
+  memset(first,0,sizeof(first));
+  memcpy(first+16-extra,data,extra);
+  head = _mm_loadu_si128((__m128i *)first);
+  data += extra;
+
+  /* Four roots at a time to keep the shuffle unit busy */
+  for(i=0;i<sp->nroots4;i+=4){
+    for(k=0;k<4;k++)
+      acc[k] = head;
+    for(j=0;j<nblocks;j++){
+      d = _mm_loadu_si128((__m128i *)(data + 16*j));
+      for(k=0;k<4;k++)
+	acc[k] = _mm_xor_si128(gfmul(acc[k],sp->tab[i+k][1]),d);
+    }
+    for(k=0;k<4;k++){
+      /* Lane r carries weight b^(15-r); fold down to lane 0 */
+      acc[k] = _mm_xor_si128(gfmul(acc[k],sp->tab[i+k][2]),_mm_srli_si128(acc[k],8));
+      acc[k] = _mm_xor_si128(gfmul(acc[k],sp->tab[i+k][3]),_mm_srli_si128(acc[k],4));
+      acc[k] = _mm_xor_si128(gfmul(acc[k],sp->tab[i+k][4]),_mm_srli_si128(acc[k],2));
+      acc[k] = _mm_xor_si128(gfmul(acc[k],sp->tab[i+k][5]),_mm_srli_si128(acc[k],1));
+      if(i+k < sp->nroots){
+	s[i+k] = _mm_cvtsi128_si32(acc[k]);
+	err |= s[i+k];
+      }
+    }
+  }
+  return err;
+}
+
+/* Interleaved codewords. A register holds m consecutive symbols of each of
+ * the depth codewords, m the largest power of 2 that fits, so every lane
+ * still runs Horner's rule with the same multiplier b^m. The lane groups
+ * are folded together at the end as for a single codeword
+ */
+/* Apply the linear map with nibble tables clo and chi to 16 symbols */
+static inline __m128i convert(__m128i x,__m128i clo,__m128i chi){
+  __m128i mask = _mm_set1_epi8(0x0f);
+
+  return _mm_xor_si128(_mm_shuffle_epi8(clo,_mm_and_si128(x,mask)),
+		       _mm_shuffle_epi8(chi,_mm_and_si128(_mm_srli_epi16(x,4),mask)));
+}
+
+/* Byte shifts by a variable count n (0-16), as shuffles: bytes n..n+15 of
+ * a register followed by zeros, or of zeros followed by a register
+ */
+static const unsigned char Shift_idx[48] = {
+  0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,
+  0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,
+  0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,
+};
+
+static inline __m128i shr(__m128i x,int n){
+  return _mm_shuffle_epi8(x,_mm_loadu_si128((__m128i *)(Shift_idx+16+n)));
+}
+
+/* Fold the m lane groups of depth lanes down to one, codeword c in lane c */
+static inline __m128i fold(__m128i acc,struct rs_syndrome *sp,int root,int m,int depth){
+  while(m > 1){
+    m >>= 1;
+    acc = _mm_xor_si128(gfmul(acc,sp->tab[root][SYN_POWERS-1-__builtin_ctz(m)]),shr(acc,m*depth));
+  }
+  return acc;
+}
+
+int rs_syndrome_il_ssse3(void *p,unsigned char *s,const unsigned char *data,int len,int depth,const unsigned char *conv){
+  struct rs_syndrome *sp = p;
+  unsigned char first[16],last[16],lanes[4][16];
+  __m128i acc[4],tlo[4],thi[4],d,head,tail,clo,chi;
+  int m,pw,L,extra,nblocks,nsafe,i,j,k,c,mask = 0;
+
+  if(depth == 1)
+    m = 16,pw = 1;
+  else if(depth == 2)
+    m = 8,pw = 2;
+  else if(depth <= 4)
+    m = 4,pw = 3;
+  else
+    m = 2,pw = 4;
+  L = depth * m; /* Bytes per block; the rest of the register is ignored */
+  extra = len % m;
+  nblocks = len / m;
+
+  memset(first,0,sizeof(first));
+  memcpy(first + (m-extra)*depth,data,extra*depth);
+  data += extra*depth;
+  /* Don't read past the end of the frame; at most one block is too close */
+  nsafe = nblocks;
+  if(L < 16 && nsafe > 0 && (nsafe-1)*L + 16 > nblocks*L)
+    nsafe--;
+  memset(last,0,sizeof(last));
+  if(nsafe < nblocks)
+    memcpy(last,data + nsafe*L,L);
+
+  /* With no conversion, use the identity map rather than test for it in the loop */
+  clo = _mm_setr_epi8(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
+  chi = _mm_slli_epi16(clo,4);
+  if(conv != NULL){
+    clo = _mm_loadu_si128((__m128i *)conv);
+    chi = _mm_loadu_si128((__m128i *)(conv+16));
+  }
+  head = convert(_mm_loadu_si128((__m128i *)first),clo,chi);
+  tail = convert(_mm_loadu_si128((__m128i *)last),clo,chi);
+  for(i=0;i<sp->nroots4;i+=4){
+    for(k=0;k<4;k++){
+      acc[k] = head;
+      tlo[k] = _mm_load_si128((__m128i *)sp->tab[i+k][pw]);
+      thi[k] = _mm_load_si128((__m128i *)(sp->tab[i+k][pw]+16));
+    }
+    for(j=0;j<nsafe;j++){
+      d = convert(_mm_loadu_si128((__m128i *)(data + j*L)),clo,chi);
+      for(k=0;k<4;k++)
+	acc[k] = _mm_xor_si128(convert(acc[k],tlo[k],thi[k]),d);
+    }
+    if(nsafe < nblocks){
+      for(k=0;k<4;k++)
+	acc[k] = _mm_xor_si128(convert(acc[k],tlo[k],thi[k]),tail);
+    }
+    for(k=0;k<4 && i+k < sp->nroots;k++){
+      _mm_storeu_si128((__m128i *)lanes[k],fold(acc[k],sp,i+k,m,depth));
+      for(c=0;c<depth;c++){
+	s[c*sp->nroots + i+k] = lanes[k][c];
+	if(lanes[k][c] != 0)
+	  mask |= 1 << c;
+      }
+    }
+  }
+  return mask;
+}
@@ -42,6 +42,8 @@ struct etab {
 int exercise_char(struct etab *e);
 int exercise_int(struct etab *e);
 int exercise_8(void);
+int exercise_ccsds(void);
+int exercise_il(int dual);
 
 int main(){
   int i;
@@ -50,6 +52,11 @@ int main(){
 
   printf("Testing fixed CCSDS encoder...\n");
   exercise_8();
+  printf("Testing CCSDS dual basis codec...\n");
+  exercise_ccsds();
+  printf("Testing interleaved CCSDS codecs...\n");
+  exercise_il(0);
+  exercise_il(1);
   for(i=0;Tab[i].symsize != 0;i++){
     int nn,kk;
 
@@ -135,6 +142,118 @@ int exercise_8(void){
   return decoder_errors;
 }
 
+/* The dual basis codec against the conventional one with the basis changed by hand,
+ * then decoding errors and erasures up to the capacity of the code, with and without padding
+ */
+int exercise_ccsds(void){
+  unsigned char block[255],tblock[255],cblock[255],parity[32];
+  int errlocs[255],derrlocs[32];
+  int pad,nn,kk,i,errors,erasures,errloc,derrors;
+  int decoder_errors = 0;
+
+  for(pad=0;pad<=40;pad+=40){
+    nn = 255-pad;
+    kk = nn-32;
+    for(errors=0;errors<=16;errors++){
+      for(i=0;i<kk;i++)
+	block[i] = random() & 255;
+      encode_rs_ccsds(block,&block[kk],pad);
+
+      for(i=0;i<kk;i++)
+	cblock[i] = Tal1tab[block[i]];
+      encode_rs_8(cblock,parity,pad);
+      for(i=0;i<32;i++){
+	if(block[kk+i] != Taltab[parity[i]]){
+	  printf("pad %d dual basis encoder parity[%d] = %02x, should be %02x\n",pad,i,block[kk+i],Taltab[parity[i]]);
+	  decoder_errors++;
+	}
+      }
+
+      /* Erase as many of the corrupted symbols as there's room for */
+      erasures = random() % (33 - 2*errors);
+      memcpy(tblock,block,nn);
+      memset(errlocs,0,sizeof(errlocs));
+      for(i=0;i<errors+erasures;i++){
+	do {
+	  errloc = random() % nn;
+	} while(errlocs[errloc] != 0);
+	errlocs[errloc] = 1;
+	tblock[errloc] ^= 1 + random() % 255;
+	if(i < erasures)
+	  derrlocs[i] = errloc + pad;
+      }
+      derrors = decode_rs_ccsds(tblock,derrlocs,erasures,pad);
+      if(derrors != errors + erasures){
+	printf("pad %d dual basis decoder says %d errors, true number is %d\n",pad,derrors,errors+erasures);
+	decoder_errors++;
+      }
+      for(i=0;i<derrors;i++){
+	if(derrlocs[i] < pad || errlocs[derrlocs[i]-pad] == 0){
+	  printf("pad %d dual basis decoder indicates error in location %d without error\n",pad,derrlocs[i]);
+	  decoder_errors++;
+	}
+      }
+      if(memcmp(tblock,block,nn) != 0){
+	printf("pad %d dual basis decoder uncorrected errors!\n",pad);
+	decoder_errors++;
+      }
+    }
+  }
+  return decoder_errors;
+}
+
+/* Interleaved frames at every depth, with a different number of errors in each codeword */
+int exercise_il(int dual){
+  unsigned char frame[8*255],tframe[8*255];
+  int results[8],errs[8];
+  char errlocs[8*255];
+  int depth,pad,i,k,n,len,errloc,total,r;
+  int decoder_errors = 0;
+
+  for(depth=1;depth<=8;depth++){
+    for(pad=0;pad<=40;pad+=40){
+      n = 255-pad;
+      len = depth*n;
+      for(i=0;i<depth*(n-32);i++)
+	frame[i] = random() & 255;
+      if(dual)
+	encode_rs_ccsds_il(frame,depth,pad);
+      else
+	encode_rs_8_il(frame,depth,pad);
+
+      memcpy(tframe,frame,len);
+      memset(errlocs,0,sizeof(errlocs));
+      total = 0;
+      for(k=0;k<depth;k++){
+	errs[k] = random() % 17;
+	total += errs[k];
+	for(i=0;i<errs[k];i++){
+	  do {
+	    errloc = depth*(random() % n) + k;
+	  } while(errlocs[errloc]);
+	  errlocs[errloc] = 1;
+	  tframe[errloc] ^= 1 + random() % 255;
+	}
+      }
+      r = dual ? decode_rs_ccsds_il(tframe,depth,pad,results) : decode_rs_8_il(tframe,depth,pad,results);
+      if(r != total){
+	printf("depth %d pad %d decoder says %d errors, true number is %d\n",depth,pad,r,total);
+	decoder_errors++;
+      }
+      for(k=0;k<depth;k++){
+	if(results[k] != errs[k]){
+	  printf("depth %d pad %d codeword %d decoder says %d errors, true number is %d\n",depth,pad,k,results[k],errs[k]);
+	  decoder_errors++;
+	}
+      }
+      if(memcmp(tframe,frame,len) != 0){
+	printf("depth %d pad %d decoder uncorrected errors!\n",depth,pad);
+	decoder_errors++;
+      }
+    }
+  }
+  return decoder_errors;
+}
 
 int exercise_char(struct etab *e){
   int nn = (1<<e->symsize) - 1;
@@ -1,6 +1,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include "fec.h"
+#include "sim.h"
 
 #define	MAX_RANDOM	0x7fffffff
 
@@ -41,3 +42,182 @@ unsigned char addnoise(int sym,double amp,double gain,double offset,int clip){
     sample = clip;
   return sample;
 }
+
+/* Counter-based random numbers for parallel simulation.
+ * Each draw is a strong 64-bit mix (the SplitMix64 finalizer) of a
+ * per-stream key plus a counter, so there is no shared state to lock and
+ * any stream can be regenerated from just its seed and number. Giving
+ * every frame its own stream makes a run reproducible trial by trial no
+ * matter how the trials are spread over threads.
+ */
+#define GOLDEN 0x9e3779b97f4a7c15ULL
+
+static inline unsigned long long mix64(unsigned long long z){
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/* Start stream number 'stream' of the sequence selected by seed */
+void sim_rng_init(struct sim_rng *rng,unsigned long long seed,unsigned long long stream){
+  rng->key = mix64(seed) ^ mix64(mix64(stream) + GOLDEN);
+  rng->ctr = 0;
+  rng->iset = 0;
+}
+
+/* Uniformly distributed 64-bit random number */
+unsigned long long sim_rand64(struct sim_rng *rng){
+  return mix64(rng->key + GOLDEN * ++rng->ctr);
+}
+
+/* Reentrant normal_rand() drawing from the given stream */
+double normal_rand_r(struct sim_rng *rng,double mean, double std_dev)
+{
+  double fac,rsq,v1,v2;
+
+  if(rng->iset){
+    /* Already got one */
+    rng->iset = 0;
+    return mean + std_dev*rng->gset;
+  }
+  /* Two uniform numbers between -1 and +1 inside the unit circle, from 53 bits each */
+  do {
+    v1 = 2.0 * (sim_rand64(rng) >> 11) * (1.0/9007199254740992.0) - 1;
+    v2 = 2.0 * (sim_rand64(rng) >> 11) * (1.0/9007199254740992.0) - 1;
+    rsq = v1*v1 + v2*v2;
+  } while(rsq >= 1.0 || rsq == 0.0);
+  fac = sqrt(-2.0*log(rsq)/rsq);
+  rng->gset = v1*fac;
+  rng->iset = 1;
+  return mean + std_dev*v2*fac;
+}
+
+/* Reentrant addnoise() drawing from the given stream */
+unsigned char addnoise_r(struct sim_rng *rng,int sym,double amp,double gain,double offset,int clip){
+  int sample;
+    
+  sample = offset + gain*normal_rand_r(rng,sym?amp:-amp,1.0);
+  /* Clip to 8-bit offset range */
+  if(sample < 0)
+    sample = 0;
+  else if(sample > clip)
+    sample = clip;
+  return sample;
+}
+
+/* Channel model for the 8-bit soft decision decoders: BPSK in gaussian noise,
+ * quantized and clipped like addnoise(). A channel tabulates the cumulative
+ * probability of each received value for a sent 0 and 1, so a symbol costs one
+ * uniform draw and a short search: no logarithms, square roots or rejections,
+ * and the probabilities are exact to 2^-64. The search starts at the smallest
+ * value any uniform in the same 1/4096th of the range can give, which leaves
+ * only a step or two. setup_channel() sets up the one used by simulate() and
+ * simulate_r(); it's only read afterward, so simulate_r() is thread safe.
+ */
+#define CHANNEL_INDEX 12   /* Bits of each uniform used to start the search */
+
+struct channel {
+  unsigned long long cdf[2][256];  /* P(output <= s) * 2^64, saturated, by sent bit */
+  unsigned char start[2][1<<CHANNEL_INDEX]; /* Where to start the search, by slice of the uniforms */
+  int clip;                        /* Largest output value */
+};
+
+static struct channel Channel;
+
+static double normal_cdf(double x){
+  return 0.5 + 0.5*erf(x/M_SQRT2);
+}
+
+/* Tabulate the outputs of offset + mean + sigma*n, truncated and clipped to 0..clip,
+ * where n is unit gaussian noise and mean is -amp for a sent 0, +amp for a 1
+ */
+static void tabulate_channel(struct channel *cp,double amp,double sigma,double offset,int clip){
+  int b,s,j;
+  double p;
+
+  cp->clip = clip;
+  for(b=0;b<2;b++){
+    for(s=0;s<clip;s++){
+      /* Output is s or less when the sample is below s+1 */
+      p = normal_cdf((s + 1 - offset - (b ? amp : -amp)) / sigma);
+      cp->cdf[b][s] = p >= 1.0 ? ~0ULL : (unsigned long long)ldexp(p,64);
+    }
+    for(;s<256;s++)
+      cp->cdf[b][s] = ~0ULL;
+    s = 0;
+    for(j=0;j<(1<<CHANNEL_INDEX);j++){
+      unsigned long long u = (unsigned long long)j << (64-CHANNEL_INDEX);
+
+      while(s < clip && cp->cdf[b][s] <= u)
+	s++;
+      cp->start[b][j] = s;
+    }
+  }
+}
+
+/* Received value for uniform random u given a sent 0 or 1 */
+static inline unsigned char channel_sample(const struct channel *cp,int data,unsigned long long u){
+  const unsigned long long *cdf = cp->cdf[data != 0];
+  int s = cp->start[data != 0][u >> (64-CHANNEL_INDEX)];
+
+  /* Find the first value whose cumulative probability exceeds u */
+  while(s < cp->clip && cdf[s] <= u)
+    s++;
+  return s;
+}
+
+/* Set up simulate() for a signal amplitude and noise standard deviation,
+ * with received value s centered on s - 128, as gen_met() assumes
+ */
+void setup_channel(double signal,double noise){
+  tabulate_channel(&Channel,signal,noise,128.5,255);
+}
+
+/* Pass a 0 or 1 through the channel set up by setup_channel() */
+unsigned char simulate(int data){
+  unsigned long long u;
+
+  u = ((unsigned long long)random() << 33) ^ ((unsigned long long)random() << 2) ^ (random() & 3);
+  return channel_sample(&Channel,data,u);
+}
+
+/* Reentrant simulate() drawing from the given stream */
+unsigned char simulate_r(struct sim_rng *rng,int data){
+  return channel_sample(&Channel,data,sim_rand64(rng));
+}
+
+/* Block noise generation for the soft decision test programs: a channel
+ * of its own that gives addnoise() its distribution, and a random stream
+ */
+struct noise {
+  struct channel ch;
+  struct sim_rng rng;
+};
+
+/* Create a noise generator that gives addnoise(sym,amp,gain,offset,clip) its
+ * distribution, with a random sequence determined by seed
+ */
+void *init_noise(double amp,double gain,double offset,int clip,unsigned long long seed){
+  struct noise *np;
+
+  if(clip < 1 || clip > 255 || gain <= 0 || (np = calloc(1,sizeof(struct noise))) == NULL)
+    return NULL;
+  tabulate_channel(&np->ch,gain*amp,gain,offset,clip);
+  sim_rng_init(&np->rng,seed,0);
+  return np;
+}
+
+/* Add noise to n symbols, each 0 or 1, giving soft decisions as addnoise() would.
+ * out and bits may be the same
+ */
+void addnoise_blk(void *p,unsigned char *out,const unsigned char *bits,int n){
+  struct noise *np = p;
+  int i;
+
+  for(i=0;i<n;i++)
+    out[i] = channel_sample(&np->ch,bits[i],sim_rand64(&np->rng));
+}
+
+void free_noise(void *p){
+  free(p);
+}
@@ -7,10 +7,27 @@
 
 // Useful utilities for simulation
 double normal_rand(double mean, double std_dev);
-unsigned char addnoise(int sym, double signal, double noise);
+unsigned char addnoise(int sym,double amp,double gain,double offset,int clip);
+void *init_noise(double amp,double gain,double offset,int clip,unsigned long long seed);
+void addnoise_blk(void *np,unsigned char *out,const unsigned char *bits,int n);
+void free_noise(void *np);
 void setup_channel(double signal,double noise);
 unsigned char simulate(int data);
 
+// Independent counter-based random number stream, for simulating in parallel.
+// A stream is fully determined by its seed and number
+struct sim_rng {
+  unsigned long long key;  // Mixed from the seed and stream number
+  unsigned long long ctr;  // Draws so far
+  double gset;             // Spare gaussian deviate
+  int iset;                // gset is valid
+};
+void sim_rng_init(struct sim_rng *rng,unsigned long long seed,unsigned long long stream);
+unsigned long long sim_rand64(struct sim_rng *rng);
+double normal_rand_r(struct sim_rng *rng,double mean,double std_dev);
+unsigned char addnoise_r(struct sim_rng *rng,int sym,double amp,double gain,double offset,int clip);
+unsigned char simulate_r(struct sim_rng *rng,int data);
+
 #endif /* _SIM_H_ */
 
 
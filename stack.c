@@ -0,0 +1,264 @@
+// Soft decision stack (Zigangirov-Jelinek) sequential decoder for r=1/2 convolutional codes
+// Copyright 2026, Phil Karn, KA9Q
+// May be used under the terms of the GNU Lesser General Public License (LGPL)
+//
+// The stack algorithm keeps every explored but unextended path and always extends
+// the best one. Unlike Fano, it never re-walks a path it has already seen, so its
+// work per bit grows much more gently as the noise rises, at the cost of memory.
+// Paths are kept in Jelinek's bucketed stack: the metric range is cut into buckets
+// delta wide, each a LIFO list, and the top nonempty bucket is extended first.
+// Within a bucket the order is arbitrary, which costs little and avoids a heap.
+// The nodes come from a fixed pool. When it runs dry, the leaves in the lowest
+// bucket are discarded to make room, as they're the least likely ever to be extended.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include "fano.h"
+#include "code.h"
+
+// A node in the code tree. The ones in the buckets are the leaves waiting
+// to be extended; the ones they descend from are kept for the traceback
+// as long as they have any descendants left
+struct snode {
+  uint64_t encstate;	// Encoder state, including the bit on the branch into this node
+  int32_t gamma;	// Cumulative metric to this node
+  int32_t depth;	// Bits decoded to reach this node
+  int32_t parent;	// Node we came from, -1 at the root
+  int32_t next;		// Next node in the same bucket or the free list
+  int32_t children;	// Children still in the tree
+};
+
+struct stack {
+  const struct conv_code *code;
+  unsigned int maxbits;      // Longest frame, including tail
+  unsigned int maxnodes;     // Size of the node pool
+  struct snode *nodes;
+  int32_t freelist;          // Discarded nodes ready for reuse, -1 if none
+  unsigned int used;         // Pool nodes ever handed out this frame
+  int32_t (*metrics)[4];     // Branch metrics for every bit of the frame
+  int32_t *buckets;          // First node in each bucket, -1 if empty
+  unsigned int nbuckets;     // Allocated buckets
+  unsigned int top;          // Highest bucket that might be nonempty
+  unsigned int bottom;       // Lowest bucket that might be nonempty
+};
+
+static inline int parity(unsigned long long x){
+  return __builtin_parityll(x);
+}
+
+// Given an encoder state, return a rate 1/2 symbol pair as in fano.c
+static inline int makesyms(const struct conv_code *code,unsigned long long state){
+  return ((parity(state & code->poly1) ^ code->g1flip) << 1) | (parity(state & code->poly2) ^ code->g2flip);
+}
+
+// Create a stack decoder context for frames of up to maxbits (including tail), NULL code for the default.
+// maxnodes bounds its memory; a few times maxbits suffices at good SNR, and
+// more lets it ride out longer noise bursts before it has to drop paths
+void *create_stack(unsigned int maxbits,unsigned int maxnodes,const struct conv_code *code){
+  struct stack *sp;
+
+  if(maxbits == 0 || maxnodes < 2*maxbits || maxnodes > INT32_MAX)
+    return NULL;
+  if((sp = (struct stack *)calloc(1,sizeof(struct stack))) == NULL)
+    return NULL;
+  sp->code = code != NULL ? code : DEFAULT_CODE;
+  sp->maxbits = maxbits;
+  sp->maxnodes = maxnodes;
+  sp->nodes = malloc(maxnodes * sizeof(*sp->nodes));
+  sp->metrics = malloc(maxbits * sizeof(*sp->metrics));
+  if(sp->nodes == NULL || sp->metrics == NULL){
+    delete_stack(sp);
+    return NULL;
+  }
+  // Touch the whole pool now so decoding never takes a page fault
+  memset(sp->nodes,0,maxnodes * sizeof(*sp->nodes));
+  return sp;
+}
+
+// Delete a stack decoder context
+void delete_stack(void *p){
+  struct stack *sp = p;
+
+  if(sp != NULL){
+    free(sp->nodes);
+    free(sp->metrics);
+    free(sp->buckets);
+    free(sp);
+  }
+}
+
+// Return a node to the free list, along with any ancestors it was the last descendant of
+static void freenode(struct stack *sp,int32_t n){
+  struct snode *np;
+
+  for(;;){
+    np = &sp->nodes[n];
+    np->next = sp->freelist;
+    sp->freelist = n;
+    if((n = np->parent) < 0 || --sp->nodes[n].children != 0)
+      break;
+  }
+}
+
+// Get a free node, discarding a leaf from the lowest bucket if the pool is full.
+// Return -1 if there's nothing left to discard
+static inline int32_t getnode(struct stack *sp){
+  int32_t n;
+
+  if(sp->freelist < 0){
+    if(sp->used < sp->maxnodes)
+      return sp->used++;
+
+    // Pool full: drop the head of the lowest nonempty bucket
+    while(sp->bottom <= sp->top && sp->buckets[sp->bottom] < 0)
+      sp->bottom++;
+    if(sp->bottom > sp->top)
+      return -1;
+    n = sp->buckets[sp->bottom];
+    sp->buckets[sp->bottom] = sp->nodes[n].next;
+    freenode(sp,n);
+  }
+  n = sp->freelist;
+  sp->freelist = sp->nodes[n].next;
+  return n;
+}
+
+// Decode a frame with the stack algorithm.
+// cycles counts node extensions, comparable to Fano's forward moves.
+// Return 0 on success, -1 on timeout, if the node pool is exhausted or if the frame is too long
+int stack_decode(
+void *p,		// Decoder context from create_stack()
+unsigned long *metric,	// Final path metric (returned value)
+unsigned long *cycles,	// Cycle count (returned value)
+unsigned char *data,	// Decoded output data
+const unsigned char *symbols,	// Raw deinterleaved input symbols
+unsigned int nbits,	// Number of output bits, including tail
+int mettab[2][256],	// Metric table, [sent sym][rx symbol]
+int delta,		// Bucket width
+unsigned long maxcycles)// Decoding timeout in cycles per bit
+{
+  struct stack *sp = p;
+  const struct conv_code *code = sp->code;
+  struct snode *np;
+  int32_t (*metrics)[4] = sp->metrics;
+  int32_t n,child[2];
+  long lo,hi;           // Bounds on any path metric in this frame
+  long bmin,bmax;
+  unsigned int lowest,highest; // Range of buckets used, to be cleared afterward
+  unsigned int tail;    // First bit of the tail
+  unsigned int i,b,nb,nchildren;
+  unsigned long cycle;
+  int r = -1;
+
+  if(nbits > sp->maxbits || nbits < (unsigned int)code->k || delta < 1)
+    return -1;
+  tail = nbits - (code->k - 1);
+
+  // Compute all possible branch metrics for each symbol pair, and their extremes
+  bmin = bmax = 0;
+  for(i=0;i<nbits;i++){
+    for(b=0;b<4;b++){
+      metrics[i][b] = mettab[b >> 1][symbols[0]] + mettab[b & 1][symbols[1]];
+      if(bmin > metrics[i][b])
+	bmin = metrics[i][b];
+      if(bmax < metrics[i][b])
+	bmax = metrics[i][b];
+    }
+    symbols += 2;
+  }
+  lo = bmin * (long)nbits;
+  hi = bmax * (long)nbits;
+
+  // Size the buckets to cover every possible metric. They're all empty between frames
+  nb = (hi - lo) / delta + 1;
+  if(nb > sp->nbuckets){
+    int32_t *nbp;
+
+    if((nbp = realloc(sp->buckets,nb * sizeof(*sp->buckets))) == NULL)
+      return -1;
+    memset(nbp + sp->nbuckets,0xff,(nb - sp->nbuckets) * sizeof(*nbp)); // All -1
+    sp->buckets = nbp;
+    sp->nbuckets = nb;
+  }
+
+  // Start with just the root in the stack
+  sp->freelist = -1;
+  sp->used = 1;
+  np = &sp->nodes[0];
+  np->encstate = 0;
+  np->gamma = 0;
+  np->depth = 0;
+  np->parent = -1;
+  np->next = -1;
+  np->children = 0;
+  sp->top = sp->bottom = lowest = highest = (0 - lo) / delta;
+  sp->buckets[sp->top] = 0;
+
+  maxcycles *= nbits;
+  for(cycle=1;cycle <= maxcycles;cycle++){
+    int lsym;
+    uint64_t state;
+
+    // Take the best path off the stack
+    while(sp->buckets[sp->top] < 0)
+      sp->top--;
+    n = sp->buckets[sp->top];
+    sp->buckets[sp->top] = sp->nodes[n].next;
+    if(sp->nodes[n].depth == (int)nbits){
+      // Reached the end of the tree; done!
+      r = 0;
+      break;
+    }
+    // Get the children first, so making room for them can't discard one of them
+    nchildren = sp->nodes[n].depth < (int)tail ? 2 : 1; // The tail is all 0's
+    for(b=0;b<nchildren;b++)
+      if((child[b] = getnode(sp)) < 0)
+	goto done; // Out of nodes
+    np = &sp->nodes[n];
+    np->children = nchildren;
+
+    // Extend it with the 0-branch and the 1-branch, whose symbols
+    // are the complement of the 0-branch's because both polynomials are odd
+    state = np->encstate << 1;
+    lsym = makesyms(code,state);
+    for(b=0;b<nchildren;b++){
+      struct snode *cp = &sp->nodes[child[b]];
+      unsigned int bucket;
+
+      cp->encstate = state | b;
+      cp->gamma = np->gamma + metrics[np->depth][b ? 3^lsym : lsym];
+      cp->depth = np->depth + 1;
+      cp->parent = n;
+      cp->children = 0;
+      bucket = (uint32_t)(cp->gamma - lo) / (uint32_t)delta;
+      cp->next = sp->buckets[bucket];
+      sp->buckets[bucket] = child[b];
+      if(sp->top < bucket)
+	sp->top = bucket;
+      if(sp->bottom > bucket)
+	sp->bottom = bucket;
+      if(highest < bucket)
+	highest = bucket;
+      if(lowest > bucket)
+	lowest = bucket;
+    }
+  }
+ done:;
+  *cycles = cycle;
+  if(r == 0){
+    // Trace the winning path back to the root, one data bit per node
+    np = &sp->nodes[n];
+    *metric = np->gamma;
+    memset(data,0,nbits/8);
+    for(;np->parent >= 0;np = &sp->nodes[np->parent]){
+      i = np->depth - 1;
+      if(np->encstate & 1)
+	data[i/8] |= 0x80 >> (i & 7);
+    }
+  }
+  // Leave the buckets empty for the next frame
+  memset(sp->buckets + lowest,0xff,(highest - lowest + 1) * sizeof(*sp->buckets));
+  return r;	// 0 on successful completion, -1 on failure
+}
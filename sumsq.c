@@ -12,6 +12,9 @@ unsigned long long sumsq_port(signed short *,int);
 #ifdef __i386__
 unsigned long long sumsq_mmx(signed short *,int);
 unsigned long long sumsq_sse(signed short *,int);
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
 unsigned long long sumsq_sse2(signed short *,int);
 #endif
 
@@ -28,7 +31,13 @@ unsigned long long sumsq(signed short *in,int cnt){
   case SSE:
   case MMX:
     return sumsq_mmx(in,cnt);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
   case SSE2:
+  case SSSE3:
+  case SSE41:
+  case AVX2:
+  case AVX512BW:
     return sumsq_sse2(in,cnt);
 #endif
 
@@ -8,13 +8,37 @@
  * May be used under the terms of the GNU Lesser Public License (LGPL)
  */
 
+#ifdef __x86_64__
+#include <emmintrin.h>
+
+/* sumsq_sse2_assist.s is 32-bit code, so do the same thing with intrinsics.
+ * in must be 128-bit aligned; only the first cnt & ~7 words are summed
+ */
+static long long sumsq_sse2_assist(signed short *in,int cnt){
+  __m128i *ip = (__m128i *)in;
+  __m128i sum = _mm_setzero_si128();
+  __m128i low = _mm_set_epi32(0,-1,0,-1);
+
+  while((cnt -= 8) >= 0){
+    __m128i sq;
+
+    sq = _mm_madd_epi16(*ip,*ip); /* (S0*S0+S1*S1) (S2*S2+S3*S3) (S4*S4+S5*S5) (S6*S6+S7*S7) */
+    ip++;
+    sum = _mm_add_epi64(sum,_mm_and_si128(sq,low)); /* sum even-numbered dwords */
+    sum = _mm_add_epi64(sum,_mm_srli_epi64(sq,32)); /* sum odd-numbered dwords */
+  }
+  sum = _mm_add_epi64(sum,_mm_srli_si128(sum,8));
+  return _mm_cvtsi128_si64(sum);
+}
+#else
 long long sumsq_sse2_assist(signed short *,int);
+#endif
 
 long long sumsq_sse2(signed short *in,int cnt){
   long long sum = 0;
 
   /* Handle stuff before the next 8-byte boundary */
-  while(((int)in & 15) != 0 && cnt != 0){
+  while(((unsigned long)in & 15) != 0 && cnt != 0){
     sum += (long)in[0] * in[0];
     in++;
     cnt--;
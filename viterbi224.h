@@ -5,11 +5,26 @@
 #ifndef _VITERBI224_H_
 #define _VITERBI224_H_
 
+struct conv_code;
+
 int init_viterbi224(void *p,int starting_state);
 void *create_viterbi224(int len);
+void *create_viterbi224_code(int len,const struct conv_code *code); // Any K=24 code; NULL for the default
 int chainback_viterbi224(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
 void delete_viterbi224(void *p);
 int update_viterbi224_blk(void *p,const unsigned char *syms,int nbits);
+int traceback_viterbi224(void *p,unsigned char *data,unsigned int ringsize,unsigned int skip,unsigned int nbits,int endstate);
+
+// Parallel mode: nthreads threads (including the caller) share each bit's butterflies
+void *create_viterbi224_mt(int len,int nthreads,const struct conv_code *code);
+int update_viterbi224_blk_mt(void *p,const unsigned char *syms,int nbits);
+
+// Streaming mode: decisions are kept only for a window of depth+release bits
+void *create_viterbi224_stream(int depth,int release,int nthreads,const struct conv_code *code);
+int init_viterbi224_stream(void *p,int starting_state);
+int update_viterbi224_stream(void *p,const unsigned char *syms,int nbits,unsigned char *data);
+int flush_viterbi224_stream(void *p,unsigned char *data,int endstate);
+void delete_viterbi224_stream(void *p);
 
 
 #endif /* _VITERBI224_H_ */
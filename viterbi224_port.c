@@ -10,8 +10,10 @@
 #include "fec.h"
 #include "code.h"
 
+#define K 24 /* Constraint length of this decoder; the polynomials come from the code descriptor */
+
 // Portable version of 32-bit parity
-static inline int parity(int x){
+static inline int parity24(int x){
   x ^= x >> 16;
   x ^= x >> 8;
   x ^= x >> 4;
@@ -24,7 +26,12 @@ static inline int parity(int x){
 typedef union { uint32_t w[1<<(K-6)]; uint8_t c[1<<(K-4)];} decision_t;
 typedef union { uint32_t w[1<<(K-1)]; } metric_t;
 
-static union branchtab224 { uint32_t w[1<<(K-2)]; } Branchtab224[2] __attribute__ ((aligned(16)));
+/* Branch symbols for the first block of states only; for the others, the parity of
+ * the high (block number) state bits is folded into the received symbols
+ */
+#define BLKBITS 11 /* log2(states per block) */
+
+union branchtab224 { uint32_t w[1<<BLKBITS]; };
 
 /* State info for instance of Viterbi decoder */
 struct v224 {
@@ -33,6 +40,8 @@ struct v224 {
   decision_t *dp;          /* Pointer to current decision */
   metric_t *old_metrics,*new_metrics; /* Pointers to path metrics, swapped on every bit */
   decision_t *decisions;   /* Beginning of decisions for block */
+  union branchtab224 branchtab[2]; /* First block of branch symbols for this code */
+  int poly[2];             /* Code polynomials */
 };
 
 
@@ -53,25 +62,38 @@ int init_viterbi224(void *p,int starting_state){
   return 0;
 }
 
-/* Create a new instance of a Viterbi decoder */
-void *create_viterbi224(int len){
+/* Create a new instance of a Viterbi decoder for the given code, NULL for the default.
+ * The code must have K=24, with the oldest bit in both polynomials
+ */
+void *create_viterbi224_code(int len,const struct conv_code *code){
   struct v224 *vp;
   int state;
 
+  if(code == NULL)
+    code = DEFAULT_CODE;
+  if(code->k != K || ((code->poly1 & code->poly2) >> (K-1)) != 1)
+    return NULL;
   if((vp = (struct v224 *)malloc(sizeof(struct v224))) == NULL)
     return NULL;
   if((vp->decisions = malloc(len*sizeof(decision_t))) == NULL){
     free(vp);
     return NULL;
   }
-  for(state=0;state < (1<<(K-2));state++){
-    Branchtab224[0].w[state] = G1FLIP ^ parity((2*state) & POLY1) ? 255 : 0;
-    Branchtab224[1].w[state] = G2FLIP ^ parity((2*state) & POLY2) ? 255 : 0;
+  vp->poly[0] = code->poly1;
+  vp->poly[1] = code->poly2;
+  for(state=0;state < (1<<BLKBITS);state++){
+    vp->branchtab[0].w[state] = code->g1flip ^ parity24((2*state) & vp->poly[0]) ? 255 : 0;
+    vp->branchtab[1].w[state] = code->g2flip ^ parity24((2*state) & vp->poly[1]) ? 255 : 0;
   }
   init_viterbi224(vp,0);
   return vp;
 }
 
+/* Create a new instance of a Viterbi decoder for the default code */
+void *create_viterbi224(int len){
+  return create_viterbi224_code(len,NULL);
+}
+
 
 /* Viterbi chainback */
 int chainback_viterbi224(
@@ -103,6 +125,47 @@ int chainback_viterbi224(
   return 0;
 }
 
+/* Traceback over a ring of ringsize decisions ending just before dp, for the streaming decoder.
+ * Starting from endstate (or the best state if endstate < 0), pass over skip decisions,
+ * then decode the nbits before them. Rewinds dp when the ring is full
+ */
+int traceback_viterbi224(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int ringsize, /* Decisions in the ring */
+      unsigned int skip, /* Decisions to pass over before decoding */
+      unsigned int nbits, /* Number of data bits */
+      int endstate){ /* Starting state, -1 for the best one */
+  struct v224 *vp = p;
+  decision_t *d = vp->decisions;
+  unsigned char dbyte = 0;
+  unsigned int i,pos,state;
+
+  if(endstate < 0){
+    endstate = 0;
+    for(i=1;i<(1<<(K-1));i++)
+      if(vp->old_metrics->w[i] < vp->old_metrics->w[endstate])
+	endstate = i;
+  }
+  state = endstate & ((1<<(K-1))-1);
+  pos = vp->dp - d;
+  for(i=skip+nbits;i-- != 0;){
+    int bit;
+
+    if(i < nbits){
+      dbyte = ((state & 1) << 7) | (dbyte >> 1);
+      if((i & 7) == 0)
+	data[i>>3] = dbyte;
+    }
+    pos = (pos == 0 ? ringsize : pos) - 1;
+    bit = (d[pos].c[state >> 3] >> (state & 7)) & 1;
+    state = (bit << (K-2)) | (state >> 1);
+  }
+  if(vp->dp == d + ringsize)
+    vp->dp = d;
+  return 0;
+}
+
 /* Delete instance of a Viterbi decoder */
 void delete_viterbi224(void *p){
   struct v224 *vp = p;
@@ -122,6 +185,7 @@ int update_viterbi224_blk(void *p,const unsigned char *syms,int nbits){
   struct v224 *vp = p;
   void *tmp;
   decision_t *d;
+  unsigned int sym0=0,sym1=0;
   int i;
 
   if(p == NULL)
@@ -132,7 +196,11 @@ int update_viterbi224_blk(void *p,const unsigned char *syms,int nbits){
     for(i=0;i<(1<<(K-2));i++){
       unsigned long metric,m0,m1,m2,m3,decision0,decision1;
 
-      metric = ((Branchtab224[0].w[i] ^ syms[0]) + (Branchtab224[1].w[i] ^ syms[1]));
+      if((i & ((1<<BLKBITS)-1)) == 0){
+	sym0 = syms[0] ^ (parity24((i >> BLKBITS) << (BLKBITS+1) & vp->poly[0]) ? 255 : 0);
+	sym1 = syms[1] ^ (parity24((i >> BLKBITS) << (BLKBITS+1) & vp->poly[1]) ? 255 : 0);
+      }
+      metric = ((vp->branchtab[0].w[i & ((1<<BLKBITS)-1)] ^ sym0) + (vp->branchtab[1].w[i & ((1<<BLKBITS)-1)] ^ sym1));
       m0 = vp->old_metrics->w[i] + metric;
       m1 = vp->old_metrics->w[i+(1<<(K-2))] + (510 - metric);
       m2 = vp->old_metrics->w[i] + (510-metric);
@@ -154,3 +222,14 @@ int update_viterbi224_blk(void *p,const unsigned char *syms,int nbits){
   return 0;
 }
 
+
+/* The portable decoder has no parallel mode; these let callers of the
+ * SSE decoder's parallel interface, like the streaming decoder, use it anyway
+ */
+void *create_viterbi224_mt(int len,int nthreads,const struct conv_code *code){
+  return create_viterbi224_code(len,code);
+}
+
+int update_viterbi224_blk_mt(void *p,const unsigned char *syms,int nbits){
+  return update_viterbi224_blk(p,syms,nbits);
+}
@@ -7,10 +7,13 @@
 #include <limits.h>
 #include <stdint.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include "viterbi224.h"
 #include "code.h"
 
+#define K 24 // This kernel is specialized for K=24; the polynomials come from the code descriptor
+
 static inline int parity(int x){
   return __builtin_parity(x);
 }
@@ -19,7 +22,21 @@ static inline int parity(int x){
 typedef union { uint32_t w[1<<18]; uint16_t s[1<<19];} decision_t;
 typedef union { int16_t s[1<<23]; __m128i v[1<<20];} metric_t;
 
-static union branchtab224 { uint16_t s[1<<22]; __m128i v[1<<19];} Branchtab224[2];
+// The branch symbols are parities of the state bits, so the parity of a state splits into
+// the parity of its low bits, which repeats from block to block, and the parity of its
+// high (block number) bits, which is constant across a block. Each decoder's branchtab holds
+// only the first block for its code; branchflip224() supplies the rest when a new block starts.
+// That's 8 KB instead of 8 MB, and it stays in L1 cache.
+#define BLKBITS 8 // log2(vectors per block)
+
+union branchtab224 { uint16_t s[8<<BLKBITS]; __m128i v[1<<BLKBITS];};
+
+// Mask to flip a block's branch symbols, given the index of any vector in it
+static inline __m128i branchflip224(int poly,int i){
+  return _mm_set1_epi16(parity((i >> BLKBITS) << (BLKBITS+4) & poly) ? 255 : 0);
+}
+
+#define MAXTHREADS 64
 
 // State info for instance of Viterbi decoder
 struct v224 {
@@ -28,6 +45,20 @@ struct v224 {
   void *dp;          // Pointer to current decision
   metric_t *old_metrics,*new_metrics; // Pointers to path metrics, swapped on every bit
   void *decisions;   // Beginning of decisions for block
+  union branchtab224 branchtab[2]; // First block of branch symbols for this code
+  int poly[2];       // Code polynomials
+
+  // Worker pool for the parallel mode; nthreads == 1 means the caller does it all
+  int nthreads;
+  pthread_t threads[MAXTHREADS];
+  pthread_barrier_t barrier;
+  pthread_mutex_t gate_lock;   // Holds new workers until the whole pool has started
+  pthread_cond_t gate_cond;
+  int gate;                    // 0 closed, 1 go, -1 quit
+  const unsigned char *syms;   // Current job, published before the starting barrier
+  int nbits;                   // < 0 tells the workers to exit
+  int adjust;                  // Normalization owed by the old metrics, applied as they're read
+  int16_t minmetric[2][MAXTHREADS]; // Each worker's smallest new metric, by bit parity
 };
 
 // Initialize Viterbi decoder for start of new frame
@@ -45,16 +76,28 @@ int init_viterbi224(void *p,int starting_state){
   vp->new_metrics = &vp->metrics2;
   vp->dp = vp->decisions;
   vp->old_metrics->s[starting_state & ((1<<(K-1))-1)] = SHRT_MIN; // Bias known start state
+  vp->adjust = 0;
   return 0;
 }
 
-// Create a new instance of a Viterbi decoder
+// Create a new instance of a Viterbi decoder for the default code
 void *create_viterbi224(int len){
+  return create_viterbi224_code(len,NULL);
+}
+
+// Create a new instance of a Viterbi decoder for the given code, NULL for the default.
+// The code must have K=24, with the oldest bit in both polynomials
+void *create_viterbi224_code(int len,const struct conv_code *code){
   void *p;
   struct v224 *vp;
   int i;
   int state;
 
+  if(code == NULL)
+    code = DEFAULT_CODE;
+  if(code->k != K || ((code->poly1 & code->poly2) >> (K-1)) != 1)
+    return NULL;
+
   // Ordinary malloc() only returns 8-byte alignment, we need 16
   i = posix_memalign(&p, sizeof(__m128i),sizeof(struct v224));
   assert(i == 0);
@@ -66,10 +109,13 @@ void *create_viterbi224(int len){
   //    return NULL;
 
   vp->decisions = (decision_t *)p;
+  vp->nthreads = 1;
+  vp->poly[0] = code->poly1;
+  vp->poly[1] = code->poly2;
 
-  for(state=0;state < (1<<(K-2));state++){
-    Branchtab224[0].s[state] = G1FLIP ^ parity((2*state) & POLY1) ? 255 : 0;
-    Branchtab224[1].s[state] = G2FLIP ^ parity((2*state) & POLY2) ? 255 : 0;
+  for(state=0;state < (8<<BLKBITS);state++){
+    vp->branchtab[0].s[state] = code->g1flip ^ parity((2*state) & vp->poly[0]) ? 255 : 0;
+    vp->branchtab[1].s[state] = code->g2flip ^ parity((2*state) & vp->poly[1]) ? 255 : 0;
   }
   init_viterbi224(vp,0);
   return vp;
@@ -120,11 +166,79 @@ int chainback_viterbi224(
 
 }
 
+// Traceback over a ring of ringsize decisions ending just before dp, for the streaming decoder.
+// Starting from endstate (or the best state if endstate < 0), pass over skip decisions,
+// then decode the nbits before them. Rewinds dp when the ring is full
+int traceback_viterbi224(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int ringsize, /* Decisions in the ring */
+      unsigned int skip, /* Decisions to pass over before decoding */
+      unsigned int nbits, /* Number of data bits */
+      int endstate){ /* Starting state, -1 for the best one */
+  struct v224 *vp = p;
+  decision_t *d = (decision_t *)vp->decisions;
+  unsigned char dbyte = 0;
+  unsigned int i,pos,state;
+
+  if(endstate < 0){
+    // Find the smallest metric, then the first state that has it.
+    // Any pending adjustment applies to every state equally, so it doesn't matter here
+    __m128i minv = vp->old_metrics->v[0],target;
+
+    for(i=1;i<(1<<(K-4));i++)
+      minv = _mm_min_epi16(minv,vp->old_metrics->v[i]);
+    minv = _mm_min_epi16(minv,_mm_srli_si128(minv,8));
+    minv = _mm_min_epi16(minv,_mm_srli_si128(minv,4));
+    minv = _mm_min_epi16(minv,_mm_srli_si128(minv,2));
+    target = _mm_shufflelo_epi16(minv,0);
+    target = _mm_unpacklo_epi64(target,target);
+    for(i=0;;i++){
+      int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(vp->old_metrics->v[i],target));
+
+      if(mask != 0){
+	endstate = 8*i + __builtin_ctz(mask)/2;
+	break;
+      }
+    }
+  }
+  state = endstate & ((1<<(K-1))-1);
+  pos = (decision_t *)vp->dp - d;
+  for(i=skip+nbits;i-- != 0;){
+    int bit;
+
+    if(i < nbits){
+      // Same bit accumulation as chainback_viterbi224()
+      dbyte = ((state & 1) << 7) | (dbyte >> 1);
+      if((i & 7) == 0)
+	data[i>>3] = dbyte;
+    }
+    pos = (pos == 0 ? ringsize : pos) - 1;
+    bit = (d[pos].w[state>>5] >> (state & 31)) & 1;
+    state = (bit << (K-2)) | (state >> 1);
+  }
+  if(vp->dp == d + ringsize)
+    vp->dp = d;
+  return 0;
+}
+
 // Delete instance of a Viterbi decoder
 void delete_viterbi224(void *p){
   struct v224 *vp = p;
 
   if(vp != NULL){
+    if(vp->nthreads > 1){
+      int i;
+
+      // Release the workers with an exit job
+      vp->nbits = -1;
+      pthread_barrier_wait(&vp->barrier);
+      for(i=1;i<vp->nthreads;i++)
+	pthread_join(vp->threads[i],NULL);
+      pthread_barrier_destroy(&vp->barrier);
+      pthread_cond_destroy(&vp->gate_cond);
+      pthread_mutex_destroy(&vp->gate_lock);
+    }
     free(vp->decisions);
     free(vp);
   }
@@ -137,7 +251,7 @@ int update_viterbi224_blk(void *p,const unsigned char *syms,int nbits){
   decision_t *d = (decision_t *)vp->dp;
 
   while(nbits--){
-    __m128i sym0v,sym1v;
+    __m128i sym0v,sym1v,sym0b,sym1b;
     void *tmp;
     int i;
 
@@ -149,14 +263,23 @@ int update_viterbi224_blk(void *p,const unsigned char *syms,int nbits){
     // SSE2 doesn't support minimum of unsigned words but does minimum of signed words.
     // So we use signed shorts. SSE 4.1 does do minimum of unsigned words (PMINUW)
     // but there  doesn't seem to be any particular advantage to it
+    // Block 0 needs no flipping
+    sym0b = sym0v;
+    sym1b = sym1v;
     for(i=0; i < 1<<(K-5); i++){
       __m128i decision0,decision1,metric,m_metric,m0,m1,m2,m3,survivor0,survivor1;
 
+      if(i != 0 && (i & ((1<<BLKBITS)-1)) == 0){
+	// New block: fold its high state bit parities into the symbols
+	sym0b = _mm_xor_si128(sym0v,branchflip224(vp->poly[0],i));
+	sym1b = _mm_xor_si128(sym1v,branchflip224(vp->poly[1],i));
+      }
       // Form branch metrics
       // Because Branchtab takes on values 0 and 255, and the values of sym?v are offset binary in the range 0-255,
       // the XOR operations constitute conditional negation.
       // metric and m_metric (-metric) are in the range 0-510
-      metric = _mm_add_epi16(_mm_xor_si128(Branchtab224[0].v[i],sym0v),_mm_xor_si128(Branchtab224[1].v[i],sym1v));
+      metric = _mm_add_epi16(_mm_xor_si128(vp->branchtab[0].v[i & ((1<<BLKBITS)-1)],sym0b),
+			     _mm_xor_si128(vp->branchtab[1].v[i & ((1<<BLKBITS)-1)],sym1b));
       m_metric = _mm_sub_epi16(_mm_set1_epi16(510),metric);
     
       // Add branch metrics to path metrics using saturating signed addition
@@ -166,8 +289,6 @@ int update_viterbi224_blk(void *p,const unsigned char *syms,int nbits){
       m2 = _mm_adds_epi16(vp->old_metrics->v[i],m_metric);
     
 #if 0
-      _mm_prefetch((void *)&Branchtab224[0].v[i+1],3);
-      _mm_prefetch((void *)&Branchtab224[1].v[i+1],3);
       _mm_prefetch((void *)&vp->old_metrics->v[i+1],0);
       _mm_prefetch((void *)&vp->old_metrics->v[(1<<(K-5))+i],0);
 #endif
@@ -259,3 +380,199 @@ int update_viterbi224_blk(void *p,const unsigned char *syms,int nbits){
 }
 
 
+
+// Parallel mode: the butterflies of each bit are split into nthreads contiguous slices,
+// one per worker, with the caller acting as worker 0. A bit's butterflies read only the
+// old metrics and write disjoint parts of the new metrics and decisions, so the only
+// synchronization needed is one barrier at the end of each bit.
+//
+// Normalization can't be done in place without a second barrier, so each worker also
+// records the smallest metric in its slice. After the barrier every worker reduces the
+// same set of minima to the same adjustment, and it is subtracted as the metrics are
+// read during the next bit. The minima are double buffered by bit parity so a fast
+// worker can't overwrite them while a slow one is still reading.
+struct worker224 {
+  struct v224 *vp;
+  int id;
+};
+
+static void update_slice224(struct v224 *vp,int id){
+  const unsigned char *syms = vp->syms;
+  decision_t *d = (decision_t *)vp->dp;
+  metric_t *old_metrics = vp->old_metrics,*new_metrics = vp->new_metrics;
+  int adjust = vp->adjust;
+  int nbits = vp->nbits;
+  int first = (id << (K-5)) / vp->nthreads;
+  int last = ((id+1) << (K-5)) / vp->nthreads;
+  int bit;
+
+  for(bit=0;bit < nbits;bit++){
+    __m128i sym0v,sym1v,sym0b,sym1b,adjustv,minv;
+    union { __m128i v; int16_t s[8]; } t;
+    metric_t *tmp;
+    int i,minmetric;
+
+    sym0v = _mm_set1_epi16(syms[0]);
+    sym1v = _mm_set1_epi16(syms[1]);
+    syms += 2;
+    adjustv = _mm_set1_epi16(adjust);
+    minv = _mm_set1_epi16(SHRT_MAX);
+
+    // Same butterflies as update_viterbi224_blk(), over this worker's slice
+    sym0b = _mm_xor_si128(sym0v,branchflip224(vp->poly[0],first));
+    sym1b = _mm_xor_si128(sym1v,branchflip224(vp->poly[1],first));
+    for(i=first; i < last; i++){
+      __m128i decision0,decision1,metric,m_metric,m0,m1,m2,m3,survivor0,survivor1,old0,old1;
+
+      if(i != first && (i & ((1<<BLKBITS)-1)) == 0){
+	sym0b = _mm_xor_si128(sym0v,branchflip224(vp->poly[0],i));
+	sym1b = _mm_xor_si128(sym1v,branchflip224(vp->poly[1],i));
+      }
+      metric = _mm_add_epi16(_mm_xor_si128(vp->branchtab[0].v[i & ((1<<BLKBITS)-1)],sym0b),
+			     _mm_xor_si128(vp->branchtab[1].v[i & ((1<<BLKBITS)-1)],sym1b));
+      m_metric = _mm_sub_epi16(_mm_set1_epi16(510),metric);
+
+      // Apply any pending normalization; it can't overflow (see update_viterbi224_blk)
+      old0 = _mm_sub_epi16(old_metrics->v[i],adjustv);
+      old1 = _mm_sub_epi16(old_metrics->v[(1<<(K-5))+i],adjustv);
+      m0 = _mm_adds_epi16(old0,metric);
+      m3 = _mm_adds_epi16(old1,metric);
+      m1 = _mm_adds_epi16(old1,m_metric);
+      m2 = _mm_adds_epi16(old0,m_metric);
+
+      decision0 = _mm_cmpgt_epi16(m0,m1);
+      decision1 = _mm_cmpgt_epi16(m2,m3);
+      survivor0 = _mm_min_epi16(m0,m1);
+      survivor1 = _mm_min_epi16(m2,m3);
+      minv = _mm_min_epi16(minv,_mm_min_epi16(survivor0,survivor1));
+
+      d->s[i] = _mm_movemask_epi8(_mm_unpacklo_epi8(_mm_packs_epi16(decision0,_mm_setzero_si128()),_mm_packs_epi16(decision1,_mm_setzero_si128())));
+
+      new_metrics->v[2*i] = _mm_unpacklo_epi16(survivor0,survivor1);
+      new_metrics->v[2*i+1] = _mm_unpackhi_epi16(survivor0,survivor1);
+    }
+    minv = _mm_min_epi16(minv,_mm_srli_si128(minv,8));
+    minv = _mm_min_epi16(minv,_mm_srli_si128(minv,4));
+    minv = _mm_min_epi16(minv,_mm_srli_si128(minv,2));
+    t.v = minv;
+    vp->minmetric[bit & 1][id] = t.s[0];
+
+    pthread_barrier_wait(&vp->barrier);
+
+    // Every worker sees the same minima, so they all agree on the adjustment.
+    // Renormalize when even the best metric is halfway up the range; the spread
+    // (5000-6000 at most) then leaves plenty of headroom below SHRT_MAX
+    minmetric = SHRT_MAX;
+    for(i=0;i<vp->nthreads;i++)
+      if(minmetric > vp->minmetric[bit & 1][i])
+	minmetric = vp->minmetric[bit & 1][i];
+    adjust = minmetric >= 0 ? minmetric - SHRT_MIN : 0;
+
+    d++;
+    tmp = old_metrics;
+    old_metrics = new_metrics;
+    new_metrics = tmp;
+  }
+  if(id == 0){
+    // All the other workers are past the last barrier and no longer look at these
+    vp->dp = d;
+    vp->old_metrics = old_metrics;
+    vp->new_metrics = new_metrics;
+    vp->adjust = adjust;
+  }
+}
+
+// Let the workers held at the start gate go, or tell them to quit
+static void open_gate224(struct v224 *vp,int gate){
+  pthread_mutex_lock(&vp->gate_lock);
+  vp->gate = gate;
+  pthread_cond_broadcast(&vp->gate_cond);
+  pthread_mutex_unlock(&vp->gate_lock);
+}
+
+static void *worker224(void *arg){
+  struct worker224 *w = arg;
+  struct v224 *vp = w->vp;
+  int id = w->id,gate;
+
+  free(w);
+  // The barrier doesn't exist until every worker has started
+  pthread_mutex_lock(&vp->gate_lock);
+  while((gate = vp->gate) == 0)
+    pthread_cond_wait(&vp->gate_cond,&vp->gate_lock);
+  pthread_mutex_unlock(&vp->gate_lock);
+  if(gate < 0)
+    return NULL;
+
+  for(;;){
+    // Wait for the caller to publish a job
+    pthread_barrier_wait(&vp->barrier);
+    if(vp->nbits < 0)
+      break;
+    update_slice224(vp,id);
+  }
+  return NULL;
+}
+
+// Create a decoder whose updates are spread over nthreads threads, including the caller's
+void *create_viterbi224_mt(int len,int nthreads,const struct conv_code *code){
+  struct v224 *vp;
+  int i,j;
+
+  if(nthreads < 1 || nthreads > MAXTHREADS || (vp = create_viterbi224_code(len,code)) == NULL)
+    return NULL;
+  if(nthreads == 1)
+    return vp;
+
+  if(pthread_mutex_init(&vp->gate_lock,NULL) != 0){
+    delete_viterbi224(vp);
+    return NULL;
+  }
+  if(pthread_cond_init(&vp->gate_cond,NULL) != 0){
+    pthread_mutex_destroy(&vp->gate_lock);
+    delete_viterbi224(vp);
+    return NULL;
+  }
+  vp->gate = 0;
+  for(i=1;i<nthreads;i++){
+    struct worker224 *w;
+
+    if((w = malloc(sizeof(struct worker224))) == NULL)
+      break;
+    w->vp = vp;
+    w->id = i;
+    if(pthread_create(&vp->threads[i],NULL,worker224,w) != 0){
+      free(w);
+      break;
+    }
+  }
+  if(i < nthreads || pthread_barrier_init(&vp->barrier,NULL,nthreads) != 0){
+    // Send home the workers that did start
+    open_gate224(vp,-1);
+    for(j=1;j<i;j++)
+      pthread_join(vp->threads[j],NULL);
+    pthread_cond_destroy(&vp->gate_cond);
+    pthread_mutex_destroy(&vp->gate_lock);
+    delete_viterbi224(vp);
+    return NULL;
+  }
+  vp->nthreads = nthreads;
+  open_gate224(vp,1);
+  return vp;
+}
+
+// Process received symbols with the worker pool
+int update_viterbi224_blk_mt(void *p,const unsigned char *syms,int nbits){
+  struct v224 *vp = p;
+
+  if(vp->nthreads == 1)
+    return update_viterbi224_blk(p,syms,nbits);
+  if(nbits <= 0)
+    return 0;
+
+  vp->syms = syms;
+  vp->nbits = nbits;
+  pthread_barrier_wait(&vp->barrier); // Start the workers
+  update_slice224(vp,0);
+  return 0;
+}
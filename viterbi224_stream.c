@@ -0,0 +1,117 @@
+// Streaming (windowed) K=24 r=1/2 Viterbi decoding
+// Copyright 2026, Phil Karn, KA9Q
+// May be used under the terms of the GNU Lesser General Public License (LGPL)
+//
+// A block decoder keeps a 1 MB decision for every bit of the frame, so long
+// frames need gigabytes. This keeps decisions only in a ring of depth+release
+// bits. Whenever the ring fills, a traceback from the best state through the
+// newest depth decisions pins the state at the checkpoint depth bits back, and
+// the release bits before that checkpoint are decoded from it and handed to the
+// caller. Each segment is final once released, so memory is set by the window,
+// not the frame length.
+#include <stdlib.h>
+
+#include "viterbi224.h"
+
+struct v224stream {
+  void *vp;              // Block decoder holding the metrics and decision ring
+  unsigned int depth;    // Traceback depth to each checkpoint
+  unsigned int release;  // Bits decoded from each checkpoint
+  unsigned int ringsize; // Decisions in the ring
+  unsigned int pos;      // Ring index of the next decision
+  unsigned int fill;     // Decisions not yet released
+};
+
+// Create a streaming decoder with the given traceback depth and release size in bits,
+// each rounded up to a multiple of 8, using nthreads threads for the updates and
+// the given code (NULL for the default).
+// The ring holds depth+release decisions of 1 MB each. About 5 constraint
+// lengths of depth is enough; a longer release means fewer best-state searches
+void *create_viterbi224_stream(int depth,int release,int nthreads,const struct conv_code *code){
+  struct v224stream *sp;
+
+  if(depth < 8)
+    depth = 8;
+  if(release < 8)
+    release = 8;
+  if((sp = (struct v224stream *)malloc(sizeof(struct v224stream))) == NULL)
+    return NULL;
+  sp->depth = (depth + 7) & ~7;
+  sp->release = (release + 7) & ~7;
+  sp->ringsize = sp->depth + sp->release;
+  if((sp->vp = create_viterbi224_mt(sp->ringsize,nthreads,code)) == NULL){
+    free(sp);
+    return NULL;
+  }
+  init_viterbi224_stream(sp,0);
+  return sp;
+}
+
+// Initialize a streaming decoder for the start of a new stream
+int init_viterbi224_stream(void *p,int starting_state){
+  struct v224stream *sp = p;
+
+  sp->pos = 0;
+  sp->fill = 0;
+  return init_viterbi224(sp->vp,starting_state);
+}
+
+// Decode nbits worth of symbols, releasing decoded data as it becomes final.
+// data must have room for (nbits + release)/8 + 1 bytes, as a call can finish off a
+// segment begun by earlier calls. Returns the number of bits written to data, always
+// a multiple of 8
+int update_viterbi224_stream(void *p,const unsigned char *syms,int nbits,unsigned char *data){
+  struct v224stream *sp = p;
+  int n,out = 0;
+
+  while(nbits > 0){
+    // Stop when the ring fills
+    n = nbits;
+    if(n > (int)(sp->ringsize - sp->fill))
+      n = sp->ringsize - sp->fill;
+    if(n > (int)(sp->ringsize - sp->pos))
+      n = sp->ringsize - sp->pos;
+
+    update_viterbi224_blk_mt(sp->vp,syms,n);
+    syms += 2*n;
+    nbits -= n;
+    sp->pos += n;
+    sp->fill += n;
+
+    if(sp->fill == sp->ringsize){
+      // Release the oldest segment, decoded back from the checkpoint
+      traceback_viterbi224(sp->vp,data+out/8,sp->ringsize,sp->depth,sp->release,-1);
+      out += sp->release;
+      sp->fill -= sp->release;
+    } else if(sp->pos == sp->ringsize)
+      traceback_viterbi224(sp->vp,NULL,sp->ringsize,0,0,0); // Just wrap the ring
+    if(sp->pos == sp->ringsize)
+      sp->pos = 0;
+  }
+  return out;
+}
+
+// Release everything still held, tracing back from endstate if the
+// stream ended with a tail, or from the best state if endstate is -1.
+// data must have room for (depth+release)/8 bytes. Returns the number of bits written
+int flush_viterbi224_stream(void *p,unsigned char *data,int endstate){
+  struct v224stream *sp = p;
+  int n;
+
+  if(sp->fill == 0)
+    return 0;
+  n = sp->fill;
+  traceback_viterbi224(sp->vp,data,sp->ringsize,0,n,endstate);
+  sp->fill = 0;
+  return n;
+}
+
+// Delete a streaming decoder
+void delete_viterbi224_stream(void *p){
+  struct v224stream *sp = p;
+
+  if(sp != NULL){
+    delete_viterbi224(sp->vp);
+    free(sp);
+  }
+}
@@ -6,6 +6,16 @@
 #include <memory.h>
 #include "fec.h"
 
+#define PACKCHUNK 256 /* Data bits per piece of packed symbols */
+
+/* DVB-S (EN 300 421) puncturing: X = 10, 101, 10101, 1000101 and
+ * Y = 11, 110, 11010, 1111010, listed here as Y,X pairs
+ */
+const struct puncture V27punct23 = {2,{1,1, 1,0}};
+const struct puncture V27punct34 = {3,{1,1, 1,0, 0,1}};
+const struct puncture V27punct56 = {5,{1,1, 1,0, 0,1, 1,0, 0,1}};
+const struct puncture V27punct78 = {7,{1,1, 1,0, 1,0, 1,0, 0,1, 1,0, 0,1}};
+
 /* Create a new instance of a Viterbi decoder */
 void *create_viterbi27(int len){
   find_cpu_mode();
@@ -23,13 +33,20 @@ void *create_viterbi27(int len){
     return create_viterbi27_mmx(len);
   case SSE:
     return create_viterbi27_sse(len);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
   case SSE2:
+  case SSSE3:
+  case SSE41:
     return create_viterbi27_sse2(len);
+  case AVX2:
+  case AVX512BW:
+    return create_viterbi27_avx2(len);
 #endif
   }
 }
 
-/* Initialize Viterbi decoder for start of new frame */
+/* Initialize Viterbi decoder for start of new frame; starting_state -1 if unknown */
 int init_viterbi27(void *p,int starting_state){
     switch(Cpu_mode){
     case PORT:
@@ -44,8 +61,15 @@ int init_viterbi27(void *p,int starting_state){
       return init_viterbi27_mmx(p,starting_state);
     case SSE:
       return init_viterbi27_sse(p,starting_state);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
     case SSE2:
+    case SSSE3:
+    case SSE41:
       return init_viterbi27_sse2(p,starting_state);
+    case AVX2:
+    case AVX512BW:
+      return init_viterbi27_avx2(p,starting_state);
 #endif
     }
 }
@@ -70,8 +94,50 @@ int chainback_viterbi27(
       return chainback_viterbi27_mmx(p,data,nbits,endstate);
     case SSE:
       return chainback_viterbi27_sse(p,data,nbits,endstate);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
     case SSE2:
+    case SSSE3:
+    case SSE41:
       return chainback_viterbi27_sse2(p,data,nbits,endstate);
+    case AVX2:
+    case AVX512BW:
+      return chainback_viterbi27_avx2(p,data,nbits,endstate);
+#endif
+    }
+}
+
+/* Streaming traceback through a ring of decisions, see update_viterbi27_stream() */
+int traceback_viterbi27(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int ringsize, /* Decisions in the ring */
+      unsigned int skip, /* Decisions to pass over before decoding */
+      unsigned int nbits, /* Number of data bits */
+      int endstate){ /* Starting state, -1 for the best one */
+
+    switch(Cpu_mode){
+    case PORT:
+    default:
+      return traceback_viterbi27_port(p,data,ringsize,skip,nbits,endstate);
+#ifdef __VEC__
+    case ALTIVEC:
+      return traceback_viterbi27_av(p,data,ringsize,skip,nbits,endstate);
+#endif
+#ifdef __i386__
+    case MMX:
+      return traceback_viterbi27_mmx(p,data,ringsize,skip,nbits,endstate);
+    case SSE:
+      return traceback_viterbi27_sse(p,data,ringsize,skip,nbits,endstate);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
+    case SSE2:
+    case SSSE3:
+    case SSE41:
+      return traceback_viterbi27_sse2(p,data,ringsize,skip,nbits,endstate);
+    case AVX2:
+    case AVX512BW:
+      return traceback_viterbi27_avx2(p,data,ringsize,skip,nbits,endstate);
 #endif
     }
 }
@@ -95,9 +161,17 @@ void delete_viterbi27(void *p){
     case SSE:
       delete_viterbi27_sse(p);
       break;
+#endif
+#if defined(__i386__) || defined(__x86_64__)
     case SSE2:
+    case SSSE3:
+    case SSE41:
       delete_viterbi27_sse2(p);
       break;
+    case AVX2:
+    case AVX512BW:
+      delete_viterbi27_avx2(p);
+      break;
 #endif
     }
 }
@@ -120,8 +194,341 @@ int update_viterbi27_blk(void *p,unsigned char syms[],int nbits){
       return update_viterbi27_blk_mmx(p,syms,nbits);
     case SSE:
       return update_viterbi27_blk_sse(p,syms,nbits);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
     case SSE2:
+    case SSSE3:
+    case SSE41:
       return update_viterbi27_blk_sse2(p,syms,nbits);
+    case AVX2:
+    case AVX512BW:
+      return update_viterbi27_blk_avx2(p,syms,nbits);
+#endif
+    }
+}
+
+/* Update decoder with packed symbols of symbits bits each (1 for hard
+ * decisions), as from pack_syms(). They're expanded a few hundred bits
+ * at a time into a buffer that stays in L1 cache, right ahead of the
+ * branch metric computation, so memory only sees the packed stream.
+ * Returns the sum of what update_viterbi27_blk() returned, or -1 for a bad symbits
+ */
+int update_viterbi27_blk_packed(void *p,const unsigned char *packed,int nbits,int symbits){
+  unsigned char syms[2*PACKCHUNK];
+  int n,r = 0;
+
+  if(symbits < 1 || symbits > 8)
+    return -1;
+  while(nbits > 0){
+    n = nbits < PACKCHUNK ? nbits : PACKCHUNK;
+    unpack_syms(syms,packed,2*n,symbits);
+    r += update_viterbi27_blk(p,syms,n);
+    packed += 2*PACKCHUNK*symbits/8; /* Only a last partial chunk isn't byte aligned */
+    nbits -= n;
+  }
+  return r;
+}
+
+/* Update decoder with a block of punctured symbols. Each deleted symbol
+ * is restored as an erasure (128) in a small buffer, a piece at a time just
+ * ahead of the decoder, so the caller never has to build the full rate 1/2
+ * stream. Each call starts at the beginning of the puncturing pattern.
+ * Returns the number of symbols used, or -1 for a bad pattern
+ */
+int update_viterbi27_blk_punct(void *p,const unsigned char *syms,int nbits,const struct puncture *pp){
+  unsigned char buf[2*PACKCHUNK];
+  const unsigned char *start = syms;
+  int i,n,phase = 0;
+
+  if(pp->period < 1 || pp->period > MAXPUNCT)
+    return -1;
+  while(nbits > 0){
+    n = nbits < PACKCHUNK ? nbits : PACKCHUNK;
+    for(i=0;i<2*n;i++){
+      buf[i] = pp->keep[phase] ? *syms++ : 128;
+      if(++phase == 2*pp->period)
+	phase = 0;
+    }
+    update_viterbi27_blk(p,buf,n);
+    nbits -= n;
+  }
+  return syms - start;
+}
+
+/* Batched decoding of many independent frames, one frame per SIMD lane */
+
+/* Create a batch of nframes decoders, each for frames of up to len bits */
+void *create_viterbi27_batch(int nframes,int len){
+  find_cpu_mode();
+
+  switch(Cpu_mode){
+  case PORT:
+  default:
+    return create_viterbi27_batch_port(nframes,len);
+#if defined(__i386__) || defined(__x86_64__)
+  case SSE2:
+  case SSSE3:
+  case SSE41:
+    return create_viterbi27_batch_sse2(nframes,len);
+  case AVX2:
+  case AVX512BW:
+    return create_viterbi27_batch_avx2(nframes,len);
+#endif
+  }
+}
+
+/* Initialize every frame of a batch; starting_state[] may be NULL for all 0 */
+int init_viterbi27_batch(void *p,int starting_state[]){
+    switch(Cpu_mode){
+    case PORT:
+    default:
+      return init_viterbi27_batch_port(p,starting_state);
+#if defined(__i386__) || defined(__x86_64__)
+    case SSE2:
+    case SSSE3:
+    case SSE41:
+      return init_viterbi27_batch_sse2(p,starting_state);
+    case AVX2:
+    case AVX512BW:
+      return init_viterbi27_batch_avx2(p,starting_state);
 #endif
     }
 }
+
+/* Update every frame with nbits decoded bits' worth of symbols;
+ * syms[i] points to the next 2*nbits symbols of frame i
+ */
+int update_viterbi27_batch(void *p,unsigned char *syms[],int nbits){
+    switch(Cpu_mode){
+    case PORT:
+    default:
+      return update_viterbi27_batch_port(p,syms,nbits);
+#if defined(__i386__) || defined(__x86_64__)
+    case SSE2:
+    case SSSE3:
+    case SSE41:
+      return update_viterbi27_batch_sse2(p,syms,nbits);
+    case AVX2:
+    case AVX512BW:
+      return update_viterbi27_batch_avx2(p,syms,nbits);
+#endif
+    }
+}
+
+/* Viterbi chainback for one frame of a batch */
+int chainback_viterbi27_batch(
+      void *p,
+      int frame,           /* Which frame of the batch */
+      unsigned char *data, /* Decoded output data */
+      unsigned int nbits, /* Number of data bits */
+      unsigned int endstate){ /* Terminal encoder state */
+
+    switch(Cpu_mode){
+    case PORT:
+    default:
+      return chainback_viterbi27_batch_port(p,frame,data,nbits,endstate);
+#if defined(__i386__) || defined(__x86_64__)
+    case SSE2:
+    case SSSE3:
+    case SSE41:
+      return chainback_viterbi27_batch_sse2(p,frame,data,nbits,endstate);
+    case AVX2:
+    case AVX512BW:
+      return chainback_viterbi27_batch_avx2(p,frame,data,nbits,endstate);
+#endif
+    }
+}
+
+/* Delete a batch of Viterbi decoders */
+void delete_viterbi27_batch(void *p){
+    switch(Cpu_mode){
+    case PORT:
+    default:
+      delete_viterbi27_batch_port(p);
+      break;
+#if defined(__i386__) || defined(__x86_64__)
+    case SSE2:
+    case SSSE3:
+    case SSE41:
+      delete_viterbi27_batch_sse2(p);
+      break;
+    case AVX2:
+    case AVX512BW:
+      delete_viterbi27_batch_avx2(p);
+      break;
+#endif
+    }
+}
+
+/* Streaming decoding of an unframed symbol stream. The block decoder's
+ * decisions are used as a ring of 2*depth entries; every depth bits, the
+ * decoder traces back depth bits from the best state and releases the
+ * depth bits before that
+ */
+struct v27stream {
+  void *vp;              /* Block decoder holding the metrics and decision ring */
+  unsigned int depth;    /* Traceback depth, also the bits released at a time */
+  unsigned int ringsize; /* Decisions in the ring */
+  unsigned int pos;      /* Ring index of the next decision */
+  int fill;              /* Decisions not yet released, less the 6 that only cover the start state */
+};
+
+/* Create a streaming decoder with the given traceback depth in bits,
+ * rounded up to a multiple of 8. About 5 constraint lengths is enough
+ */
+void *create_viterbi27_stream(int depth){
+  struct v27stream *sp;
+
+  if(depth < 8)
+    depth = 8;
+  if((sp = (struct v27stream *)malloc(sizeof(struct v27stream))) == NULL)
+    return NULL;
+  sp->depth = (depth + 7) & ~7;
+  sp->ringsize = 2*sp->depth;
+  /* The block decoder allocates room for its 6-bit tail too */
+  if((sp->vp = create_viterbi27(sp->ringsize - 6)) == NULL){
+    free(sp);
+    return NULL;
+  }
+  init_viterbi27_stream(sp,0);
+  return sp;
+}
+
+/* Initialize a streaming decoder for the start of a new stream */
+int init_viterbi27_stream(void *p,int starting_state){
+  struct v27stream *sp = p;
+
+  sp->pos = 0;
+  sp->fill = -6;
+  return init_viterbi27(sp->vp,starting_state);
+}
+
+/* Decode nbits worth of symbols, releasing decoded data as it becomes final.
+ * data must have room for (nbits + depth)/8 + 1 bytes. Returns the number
+ * of bits written to data, always a multiple of 8
+ */
+int update_viterbi27_stream(void *p,unsigned char *syms,int nbits,unsigned char *data){
+  struct v27stream *sp = p;
+  int n,out = 0;
+
+  while(nbits > 0){
+    /* Stop at the next release and at the end of the ring */
+    n = nbits;
+    if(sp->fill < (int)sp->ringsize && n > (int)sp->ringsize - sp->fill)
+      n = sp->ringsize - sp->fill;
+    if(n > (int)(sp->ringsize - sp->pos))
+      n = sp->ringsize - sp->pos;
+
+    update_viterbi27_blk(sp->vp,syms,n);
+    syms += 2*n;
+    nbits -= n;
+    sp->pos += n;
+    sp->fill += n;
+
+    if(sp->fill == (int)sp->ringsize){
+      /* Release the oldest depth bits */
+      traceback_viterbi27(sp->vp,data+out/8,sp->ringsize,sp->depth,sp->depth,-1);
+      out += sp->depth;
+      sp->fill -= sp->depth;
+    } else if(sp->pos == sp->ringsize)
+      traceback_viterbi27(sp->vp,NULL,sp->ringsize,0,0,0); /* Just wrap the ring */
+    if(sp->pos == sp->ringsize)
+      sp->pos = 0;
+  }
+  return out;
+}
+
+/* Release everything still held, tracing back from endstate if the
+ * stream ended with a tail, or from the best state if endstate is -1.
+ * data must have room for 2*depth/8 bytes. Returns the number of bits written
+ */
+int flush_viterbi27_stream(void *p,unsigned char *data,int endstate){
+  struct v27stream *sp = p;
+  int n;
+
+  if(sp->fill <= 0)
+    return 0;
+  n = sp->fill;
+  traceback_viterbi27(sp->vp,data,sp->ringsize,0,n,endstate);
+  sp->fill = 0;
+  return n;
+}
+
+/* Delete a streaming decoder */
+void delete_viterbi27_stream(void *p){
+  struct v27stream *sp = p;
+
+  if(sp != NULL){
+    delete_viterbi27(sp->vp);
+    free(sp);
+  }
+}
+
+/* Correlation of a tail-biting frame's symbols with the ones data would produce */
+static long tailbite_metric27(const unsigned char *data,const unsigned char *syms,int nbits){
+  unsigned int sr;
+  long metric = 0;
+  int i;
+
+  /* The encoder starts with the last 6 data bits */
+  sr = 0;
+  for(i=nbits-6;i<nbits;i++)
+    sr = (sr << 1) | ((data[i>>3] >> (7-(i&7))) & 1);
+  for(i=0;i<nbits;i++){
+    sr = (sr << 1) | ((data[i>>3] >> (7-(i&7))) & 1);
+    metric += parity(sr & V27POLYA) ? syms[0] : 255 - syms[0];
+    metric += parity(sr & V27POLYB) ? syms[1] : 255 - syms[1];
+    syms += 2;
+  }
+  return metric;
+}
+
+/* Tail-biting frames: the encoder starts in the state its last 6 data bits
+ * leave it in, so no tail is sent. Decode with the wrap-around Viterbi
+ * algorithm: start with all states equal and run the frame through the
+ * decoder again and again, each pass starting from the last one's path
+ * metrics, until the best path starts and ends in the same state. If
+ * maxpasses run out first, take the best of the last pass's survivors that
+ * does. vp must have been created for at least nbits bits, and data must have
+ * room for (nbits+7)/8 bytes. Returns the number of passes, or -1 if no
+ * tail-biting path turned up at all; data then holds the last pass's best path
+ */
+int tailbite_viterbi27(void *vp,unsigned char *data,unsigned char *syms,int nbits,int maxpasses){
+  unsigned char *trial;
+  long metric,best;
+  int pass,state,start,end;
+
+  if(nbits < 6 || maxpasses < 1)
+    return -1;
+  init_viterbi27(vp,-1);
+  for(pass=1;pass<=maxpasses;pass++){
+    /* Each decision settles the bit 6 before the one just decoded, so
+     * start the pass 6 bits in to make the decisions line up with the data
+     */
+    update_viterbi27_blk(vp,syms+2*6,nbits-6);
+    update_viterbi27_blk(vp,syms,6);
+    /* Find the best state, then trace back from it to where its path
+     * started. That also wraps the decisions for the next pass
+     */
+    end = traceback_viterbi27(vp,NULL,nbits,0,0,-1);
+    start = traceback_viterbi27(vp,data,nbits,0,nbits,end);
+    if(start == end)
+      return pass;
+  }
+  /* Frames that keep flipping between paths never settle on their own.
+   * Score every survivor that bites its own tail and keep the best
+   */
+  if((trial = malloc((nbits+7)/8)) == NULL)
+    return -1;
+  best = -1;
+  for(state=0;state<64;state++){
+    if(traceback_viterbi27(vp,trial,nbits,0,nbits,state) != state)
+      continue;
+    if((metric = tailbite_metric27(trial,syms,nbits)) > best){
+      best = metric;
+      memcpy(data,trial,(nbits+7)/8);
+    }
+  }
+  free(trial);
+  return best >= 0 ? maxpasses : -1;
+}
@@ -0,0 +1,227 @@
+/* K=7 r=1/2 Viterbi decoder for x86 AVX2
+ * All 32 butterflies of the 64-state trellis fit in one 256-bit register
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <immintrin.h>
+#include "fec.h"
+
+typedef union { unsigned char c[64]; __m256i v[2]; } metric_t;
+typedef union { unsigned int w[2]; unsigned char c[8]; } decision_t;
+static union branchtab27 { unsigned char c[32]; __m256i v[1]; } Branchtab27_avx2[2];
+static int Init = 0;
+
+/* State info for instance of Viterbi decoder */
+struct v27 {
+  metric_t metrics1; /* path metric buffer 1 */
+  metric_t metrics2; /* path metric buffer 2 */
+  decision_t *dp;          /* Pointer to current decision */
+  metric_t *old_metrics,*new_metrics; /* Pointers to path metrics, swapped on every bit */
+  decision_t *decisions;   /* Beginning of decisions for block */
+};
+
+/* Initialize Viterbi decoder for start of new frame */
+int init_viterbi27_avx2(void *p,int starting_state){
+  struct v27 *vp = p;
+  int i;
+
+  for(i=0;i<64;i++)
+    vp->metrics1.c[i] = 63;
+
+  vp->old_metrics = &vp->metrics1;
+  vp->new_metrics = &vp->metrics2;
+  vp->dp = vp->decisions;
+  if(starting_state >= 0)
+    vp->old_metrics->c[starting_state & 63] = 0; /* Bias known start state */
+  return 0;
+}
+
+/* Create a new instance of a Viterbi decoder */
+void *create_viterbi27_avx2(int len){
+  void *p;
+  struct v27 *vp;
+  int state;
+
+  if(!Init){
+    /* Initialize branch tables */
+    for(state=0;state < 32;state++){
+      Branchtab27_avx2[0].c[state] = parity((2*state) & V27POLYA) ? 255:0;
+      Branchtab27_avx2[1].c[state] = parity((2*state) & V27POLYB) ? 255:0;
+    }
+    Init++;
+  }
+  /* The metrics must be 32-byte aligned for AVX2, more than malloc() promises */
+  if(posix_memalign(&p,sizeof(__m256i),sizeof(struct v27)))
+    return NULL;
+  vp = (struct v27 *)p;
+  if((vp->decisions = (decision_t *)malloc((len+6)*sizeof(decision_t))) == NULL){
+    free(vp);
+    return NULL;
+  }
+  init_viterbi27_avx2(vp,0);
+
+  return vp;
+}
+
+/* Viterbi chainback */
+int chainback_viterbi27_avx2(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int nbits, /* Number of data bits */
+      unsigned int endstate){ /* Terminal encoder state */
+  struct v27 *vp = p;
+  decision_t *d = vp->decisions;
+
+  /* Make room beyond the end of the encoder register so we can
+   * accumulate a full byte of decoded data
+   */
+  endstate %= 64;
+  endstate <<= 2;
+
+  /* The store into data[] only needs to be done every 8 bits.
+   * But this avoids a conditional branch, and the writes will
+   * combine in the cache anyway
+   */
+  d += 6; /* Look past tail */
+  while(nbits-- != 0){
+    int k;
+
+    k = (d[nbits].c[(endstate>>2)/8] >> ((endstate>>2)%8)) & 1;
+    data[nbits>>3] = endstate = (endstate >> 1) | (k << 7);
+  }
+  return 0;
+}
+
+/* Delete instance of a Viterbi decoder */
+void delete_viterbi27_avx2(void *p){
+  struct v27 *vp = p;
+
+  if(vp != NULL){
+    free(vp->decisions);
+    free(vp);
+  }
+}
+
+/* Update decoder with a block of demodulated symbols
+ * Note that nbits is the number of decoded data bits, not the number
+ * of symbols!
+ */
+int update_viterbi27_blk_avx2(void *p,unsigned char *syms,int nbits){
+  struct v27 *vp = p;
+  decision_t *d = vp->dp;
+  __m256i thirtyones = _mm256_set1_epi8(31);
+
+  while(nbits--){
+    __m256i sym0v,sym1v,metric,m_metric,m0,m1,m2,m3,survivor0,survivor1,decision0,decision1,lo,hi;
+    void *tmp;
+
+    /* Splat the 0th symbol across sym0v, the 1st symbol across sym1v */
+    sym0v = _mm256_set1_epi8(syms[0]);
+    sym1v = _mm256_set1_epi8(syms[1]);
+    syms += 2;
+
+    /* Form 5-bit branch metrics for all 32 butterflies at once,
+     * exactly as sse2bfly27.s does for 16
+     */
+    metric = _mm256_avg_epu8(_mm256_xor_si256(Branchtab27_avx2[0].v[0],sym0v),
+			     _mm256_xor_si256(Branchtab27_avx2[1].v[0],sym1v));
+    /* There's no packed bytes right shift, so we use the word version and mask */
+    metric = _mm256_and_si256(_mm256_srli_epi16(metric,3),thirtyones);
+    m_metric = _mm256_xor_si256(metric,thirtyones);
+
+    /* Add branch metrics to path metrics */
+    m0 = _mm256_adds_epu8(vp->old_metrics->v[0],metric);
+    m3 = _mm256_adds_epu8(vp->old_metrics->v[1],metric);
+    m1 = _mm256_adds_epu8(vp->old_metrics->v[1],m_metric);
+    m2 = _mm256_adds_epu8(vp->old_metrics->v[0],m_metric);
+
+    /* Find survivors and decisions; ties go to the 1-branch as in the SSE2 version */
+    survivor0 = _mm256_min_epu8(m0,m1);
+    survivor1 = _mm256_min_epu8(m2,m3);
+    decision0 = _mm256_cmpeq_epi8(survivor0,m1);
+    decision1 = _mm256_cmpeq_epi8(survivor1,m3);
+
+    /* The AVX2 unpacks work within each 128-bit lane, so the low lane of each
+     * result holds states 0-31 and the high lane states 32-63. Swap the middle
+     * two lanes to put them back into state order
+     */
+    lo = _mm256_unpacklo_epi8(decision0,decision1);
+    hi = _mm256_unpackhi_epi8(decision0,decision1);
+    d->w[0] = _mm256_movemask_epi8(_mm256_permute2x128_si256(lo,hi,0x20));
+    d->w[1] = _mm256_movemask_epi8(_mm256_permute2x128_si256(lo,hi,0x31));
+
+    /* Store surviving metrics */
+    lo = _mm256_unpacklo_epi8(survivor0,survivor1);
+    hi = _mm256_unpackhi_epi8(survivor0,survivor1);
+    vp->new_metrics->v[0] = _mm256_permute2x128_si256(lo,hi,0x20);
+    vp->new_metrics->v[1] = _mm256_permute2x128_si256(lo,hi,0x31);
+
+    /* Normalize with the same conservative threshold as sse2bfly27.s */
+    if(vp->new_metrics->c[0] > 105){
+      __m256i minv;
+      __m128i t;
+
+      minv = _mm256_min_epu8(vp->new_metrics->v[0],vp->new_metrics->v[1]);
+      t = _mm_min_epu8(_mm256_castsi256_si128(minv),_mm256_extracti128_si256(minv,1));
+      t = _mm_min_epu8(t,_mm_srli_si128(t,8));
+      t = _mm_min_epu8(t,_mm_srli_si128(t,4));
+      t = _mm_min_epu8(t,_mm_srli_si128(t,2));
+      t = _mm_min_epu8(t,_mm_srli_si128(t,1));
+      minv = _mm256_broadcastb_epi8(t);
+      vp->new_metrics->v[0] = _mm256_subs_epu8(vp->new_metrics->v[0],minv);
+      vp->new_metrics->v[1] = _mm256_subs_epu8(vp->new_metrics->v[1],minv);
+    }
+    d++;
+    /* Swap pointers to old and new metrics */
+    tmp = vp->old_metrics;
+    vp->old_metrics = vp->new_metrics;
+    vp->new_metrics = tmp;
+  }
+  vp->dp = d;
+  return 0;
+}
+
+/* Streaming traceback. The decisions are treated as a ring of ringsize
+ * entries ending at the current one. Starting from endstate, or from the
+ * best state if endstate is negative, pass over the newest skip decisions
+ * and decode the nbits before them. A full ring wraps back to the start.
+ * Returns the state the traced path started from
+ */
+int traceback_viterbi27_avx2(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int ringsize, /* Decisions in the ring */
+      unsigned int skip, /* Decisions to pass over before decoding */
+      unsigned int nbits, /* Number of data bits */
+      int endstate){ /* Starting state, -1 for the best one */
+  struct v27 *vp = p;
+  decision_t *d = vp->decisions;
+  unsigned int i,pos,state;
+
+  if(endstate < 0){
+    unsigned char *m = vp->old_metrics->c;
+
+    endstate = 0;
+    for(i=1;i<64;i++)
+      if(m[i] < m[endstate])
+	endstate = i;
+  }
+  state = (endstate % 64) << 2;
+  pos = vp->dp - d;
+  for(i=skip+nbits;i-- != 0;){
+    int k;
+
+    pos = (pos == 0 ? ringsize : pos) - 1;
+    k = (d[pos].c[(state>>2)/8] >> ((state>>2)%8)) & 1;
+    state = (state >> 1) | (k << 7);
+    if(i < nbits)
+      data[i>>3] = state;
+  }
+  if(vp->dp == d + ringsize)
+    vp->dp = d;
+  return (state >> 2) & 63;
+}
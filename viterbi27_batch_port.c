@@ -0,0 +1,93 @@
+/* K=7 r=1/2 Viterbi decoder in portable C, many independent frames at once
+ * Without SIMD lanes to spread the frames across, this just runs one
+ * portable decoder per frame
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "fec.h"
+
+/* State info for a batch of Viterbi decoders */
+struct v27b {
+  int nframes;  /* Number of frames in the batch */
+  int len;      /* Decisions allocated per frame, including tail */
+  int nbits;    /* Decisions made so far in this batch */
+  void **vp;    /* One single-frame decoder per frame */
+};
+
+/* Initialize all frames for a new batch; starting_state[] may be NULL for all 0 */
+int init_viterbi27_batch_port(void *p,int starting_state[]){
+  struct v27b *vp = p;
+  int i;
+
+  for(i=0;i<vp->nframes;i++)
+    init_viterbi27_port(vp->vp[i],starting_state != NULL ? starting_state[i] : 0);
+  vp->nbits = 0;
+  return 0;
+}
+
+/* Create a batch of nframes decoders, each for frames of up to len bits */
+void *create_viterbi27_batch_port(int nframes,int len){
+  struct v27b *vp;
+  int i;
+
+  if(nframes <= 0 || (vp = (struct v27b *)malloc(sizeof(struct v27b))) == NULL)
+    return NULL;
+  vp->nframes = nframes;
+  vp->len = len + 6;
+  vp->nbits = 0;
+  if((vp->vp = (void **)calloc(nframes,sizeof(void *))) == NULL){
+    free(vp);
+    return NULL;
+  }
+  for(i=0;i<nframes;i++){
+    if((vp->vp[i] = create_viterbi27_port(len)) == NULL){
+      delete_viterbi27_batch_port(vp);
+      return NULL;
+    }
+  }
+  return vp;
+}
+
+/* Viterbi chainback for one frame of the batch */
+int chainback_viterbi27_batch_port(
+      void *p,
+      int frame,           /* Which frame of the batch */
+      unsigned char *data, /* Decoded output data */
+      unsigned int nbits, /* Number of data bits */
+      unsigned int endstate){ /* Terminal encoder state */
+  struct v27b *vp = p;
+
+  if(frame < 0 || frame >= vp->nframes)
+    return -1;
+  return chainback_viterbi27_port(vp->vp[frame],data,nbits,endstate);
+}
+
+/* Delete a batch of Viterbi decoders */
+void delete_viterbi27_batch_port(void *p){
+  struct v27b *vp = p;
+  int i;
+
+  if(vp != NULL){
+    for(i=0;i<vp->nframes;i++)
+      delete_viterbi27_port(vp->vp[i]);
+    free(vp->vp);
+    free(vp);
+  }
+}
+
+/* Update every frame in the batch with nbits decoded bits' worth of symbols.
+ * syms[i] points to the next 2*nbits symbols of frame i
+ */
+int update_viterbi27_batch_port(void *p,unsigned char *syms[],int nbits){
+  struct v27b *vp = p;
+  int i;
+
+  if(vp->nbits + nbits > vp->len)
+    return -1;
+  for(i=0;i<vp->nframes;i++)
+    update_viterbi27_blk_port(vp->vp[i],syms[i],nbits);
+  vp->nbits += nbits;
+  return 0;
+}
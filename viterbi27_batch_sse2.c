@@ -0,0 +1,212 @@
+/* K=7 r=1/2 Viterbi decoder for SSE2, many independent frames at once
+ * Each byte lane of a register belongs to a different frame, so every
+ * state of the trellis is one register and the butterflies need no shuffles
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <emmintrin.h>
+#include "fec.h"
+
+#define LANES 16 /* Frames per group */
+
+typedef struct { __m128i v[64]; } metric_t;      /* One register per state */
+typedef struct { unsigned short s[64]; } decision_t; /* One bit per frame per state */
+static unsigned char Branchidx27[32]; /* Which of the 4 branch metrics each butterfly uses */
+static int Init = 0;
+
+/* State info for a batch of Viterbi decoders */
+struct v27b {
+  int nframes;       /* Number of frames in the batch */
+  int ngroups;       /* Number of LANES-frame groups */
+  int len;           /* Decisions allocated per frame, including tail */
+  int nbits;         /* Decisions made so far in this batch */
+  metric_t *metrics1; /* Path metric buffers 1 and 2, one of each per group */
+  metric_t *metrics2;
+  metric_t **old_metrics,**new_metrics; /* Per-group pointers, swapped on every bit */
+  decision_t *decisions; /* len decisions for group 0, then group 1, ... */
+};
+
+/* Initialize all frames for a new batch; starting_state[] may be NULL for all 0 */
+int init_viterbi27_batch_sse2(void *p,int starting_state[]){
+  struct v27b *vp = p;
+  int g,i;
+
+  for(g=0;g<vp->ngroups;g++){
+    for(i=0;i<64;i++)
+      vp->metrics1[g].v[i] = _mm_set1_epi8(63);
+    vp->old_metrics[g] = &vp->metrics1[g];
+    vp->new_metrics[g] = &vp->metrics2[g];
+  }
+  /* Bias each frame's known start state */
+  for(i=0;i<vp->nframes;i++){
+    int s = starting_state != NULL ? starting_state[i] & 63 : 0;
+
+    ((unsigned char *)&vp->metrics1[i/LANES].v[s])[i%LANES] = 0;
+  }
+  vp->nbits = 0;
+  return 0;
+}
+
+/* Create a batch of nframes decoders, each for frames of up to len bits */
+void *create_viterbi27_batch_sse2(int nframes,int len){
+  struct v27b *vp;
+  int i;
+
+  if(!Init){
+    /* Bit 1 is the first encoder output, bit 0 the second */
+    for(i=0;i<32;i++)
+      Branchidx27[i] = (parity((2*i) & V27POLYA) << 1) | parity((2*i) & V27POLYB);
+    Init++;
+  }
+  if(nframes <= 0 || (vp = (struct v27b *)calloc(1,sizeof(struct v27b))) == NULL)
+    return NULL;
+  vp->nframes = nframes;
+  vp->ngroups = (nframes + LANES - 1) / LANES;
+  vp->len = len + 6;
+  /* The metrics must be 16-byte aligned, which older IA-32 malloc()s don't promise */
+  if(posix_memalign((void **)&vp->metrics1,sizeof(__m128i),vp->ngroups * sizeof(metric_t)))
+    vp->metrics1 = NULL;
+  if(posix_memalign((void **)&vp->metrics2,sizeof(__m128i),vp->ngroups * sizeof(metric_t)))
+    vp->metrics2 = NULL;
+  vp->old_metrics = malloc(vp->ngroups * sizeof(metric_t *));
+  vp->new_metrics = malloc(vp->ngroups * sizeof(metric_t *));
+  vp->decisions = malloc((size_t)vp->ngroups * vp->len * sizeof(decision_t));
+  if(vp->metrics1 == NULL || vp->metrics2 == NULL || vp->old_metrics == NULL
+     || vp->new_metrics == NULL || vp->decisions == NULL){
+    delete_viterbi27_batch_sse2(vp);
+    return NULL;
+  }
+  init_viterbi27_batch_sse2(vp,NULL);
+  return vp;
+}
+
+/* Viterbi chainback for one frame of the batch */
+int chainback_viterbi27_batch_sse2(
+      void *p,
+      int frame,           /* Which frame of the batch */
+      unsigned char *data, /* Decoded output data */
+      unsigned int nbits, /* Number of data bits */
+      unsigned int endstate){ /* Terminal encoder state */
+  struct v27b *vp = p;
+  decision_t *d;
+  int lane;
+
+  if(frame < 0 || frame >= vp->nframes)
+    return -1;
+  d = vp->decisions + (size_t)(frame / LANES) * vp->len;
+  lane = frame % LANES;
+
+  /* Make room beyond the end of the encoder register so we can
+   * accumulate a full byte of decoded data
+   */
+  endstate %= 64;
+  endstate <<= 2;
+
+  d += 6; /* Look past tail */
+  while(nbits-- != 0){
+    int k;
+
+    k = (d[nbits].s[endstate>>2] >> lane) & 1;
+    data[nbits>>3] = endstate = (endstate >> 1) | (k << 7);
+  }
+  return 0;
+}
+
+/* Delete a batch of Viterbi decoders */
+void delete_viterbi27_batch_sse2(void *p){
+  struct v27b *vp = p;
+
+  if(vp != NULL){
+    free(vp->metrics1);
+    free(vp->metrics2);
+    free(vp->old_metrics);
+    free(vp->new_metrics);
+    free(vp->decisions);
+    free(vp);
+  }
+}
+
+/* Update every frame in the batch with nbits decoded bits' worth of symbols.
+ * syms[i] points to the next 2*nbits symbols of frame i
+ */
+int update_viterbi27_batch_sse2(void *p,unsigned char *syms[],int nbits){
+  struct v27b *vp = p;
+  __m128i thirtyones = _mm_set1_epi8(31);
+  __m128i sixtyfours = _mm_set1_epi8(64);
+  int g;
+
+  if(vp->nbits + nbits > vp->len)
+    return -1;
+
+  /* Run each group through the whole block while its metrics are in cache */
+  for(g=0;g<vp->ngroups;g++){
+    decision_t *d = vp->decisions + (size_t)g * vp->len + vp->nbits;
+    metric_t *old = vp->old_metrics[g],*new = vp->new_metrics[g],*tmp;
+    int nlanes = vp->nframes - g*LANES;
+    int bit;
+
+    if(nlanes > LANES)
+      nlanes = LANES;
+
+    for(bit=0;bit<nbits;bit++){
+      union { unsigned char c[LANES]; __m128i v; } s0,s1;
+      __m128i metric[4],m_metric[4],minv;
+      int i;
+
+      /* Gather this bit's symbol pair from each frame; idle lanes see erasures */
+      for(i=0;i<nlanes;i++){
+	s0.c[i] = syms[g*LANES+i][2*bit];
+	s1.c[i] = syms[g*LANES+i][2*bit+1];
+      }
+      for(;i<LANES;i++)
+	s0.c[i] = s1.c[i] = 128;
+
+      /* Only four distinct 5-bit branch metrics exist, one per encoder output pair */
+      for(i=0;i<4;i++){
+	__m128i a = (i & 2) ? _mm_xor_si128(s0.v,_mm_set1_epi8(-1)) : s0.v;
+	__m128i b = (i & 1) ? _mm_xor_si128(s1.v,_mm_set1_epi8(-1)) : s1.v;
+
+	metric[i] = _mm_and_si128(_mm_srli_epi16(_mm_avg_epu8(a,b),3),thirtyones);
+	m_metric[i] = _mm_xor_si128(metric[i],thirtyones);
+      }
+      minv = _mm_set1_epi8(-1);
+      for(i=0;i<32;i++){
+	__m128i m0,m1,m2,m3,survivor0,survivor1;
+	int j = Branchidx27[i];
+
+	m0 = _mm_adds_epu8(old->v[i],metric[j]);
+	m1 = _mm_adds_epu8(old->v[i+32],m_metric[j]);
+	m2 = _mm_adds_epu8(old->v[i],m_metric[j]);
+	m3 = _mm_adds_epu8(old->v[i+32],metric[j]);
+	survivor0 = _mm_min_epu8(m0,m1);
+	survivor1 = _mm_min_epu8(m2,m3);
+	/* Ties go to the 1-branch, as in the single-frame SIMD decoders */
+	d->s[2*i] = _mm_movemask_epi8(_mm_cmpeq_epi8(survivor0,m1));
+	d->s[2*i+1] = _mm_movemask_epi8(_mm_cmpeq_epi8(survivor1,m3));
+	new->v[2*i] = survivor0;
+	new->v[2*i+1] = survivor1;
+	minv = _mm_min_epu8(minv,_mm_min_epu8(survivor0,survivor1));
+      }
+      /* Each frame has its own minimum, so normalize lane by lane,
+       * and only when some frame's best metric has reached 64
+       */
+      if(_mm_movemask_epi8(_mm_adds_epu8(minv,sixtyfours)) != 0){
+	for(i=0;i<64;i++)
+	  new->v[i] = _mm_subs_epu8(new->v[i],minv);
+      }
+      d++;
+      /* Swap pointers to old and new metrics */
+      tmp = old;
+      old = new;
+      new = tmp;
+    }
+    vp->old_metrics[g] = old;
+    vp->new_metrics[g] = new;
+  }
+  vp->nbits += nbits;
+  return 0;
+}
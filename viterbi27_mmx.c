@@ -36,7 +36,8 @@ int init_viterbi27_mmx(void *p,int starting_state){
   vp->old_metrics = &vp->metrics1;
   vp->new_metrics = &vp->metrics2;
   vp->dp = vp->decisions;
-  vp->old_metrics->c[starting_state & 63] = 0; /* Bias known start state */
+  if(starting_state >= 0)
+    vp->old_metrics->c[starting_state & 63] = 0; /* Bias known start state */
   return 0;
 }
 
@@ -94,3 +95,44 @@ void delete_viterbi27_mmx(void *p){
     free(vp);
   }
 }
+
+/* Streaming traceback. The decisions are treated as a ring of ringsize
+ * entries ending at the current one. Starting from endstate, or from the
+ * best state if endstate is negative, pass over the newest skip decisions
+ * and decode the nbits before them. A full ring wraps back to the start.
+ * Returns the state the traced path started from
+ */
+int traceback_viterbi27_mmx(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int ringsize, /* Decisions in the ring */
+      unsigned int skip, /* Decisions to pass over before decoding */
+      unsigned int nbits, /* Number of data bits */
+      int endstate){ /* Starting state, -1 for the best one */
+  struct v27 *vp = p;
+  decision_t *d = vp->decisions;
+  unsigned int i,pos,state;
+
+  if(endstate < 0){
+    unsigned char *m = vp->old_metrics->c;
+
+    endstate = 0;
+    for(i=1;i<64;i++)
+      if(m[i] < m[endstate])
+	endstate = i;
+  }
+  state = (endstate % 64) << 2;
+  pos = vp->dp - d;
+  for(i=skip+nbits;i-- != 0;){
+    int k;
+
+    pos = (pos == 0 ? ringsize : pos) - 1;
+    k = d[pos].c[state>>2] & 1;
+    state = (state >> 1) | (k << 7);
+    if(i < nbits)
+      data[i>>3] = state;
+  }
+  if(vp->dp == d + ringsize)
+    vp->dp = d;
+  return (state >> 2) & 63;
+}
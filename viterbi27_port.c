@@ -36,7 +36,8 @@ int init_viterbi27_port(void *p,int starting_state){
   vp->old_metrics = &vp->metrics1;
   vp->new_metrics = &vp->metrics2;
   vp->dp = vp->decisions;
-  vp->old_metrics->w[starting_state & 63] = 0; /* Bias known start state */
+  if(starting_state >= 0)
+    vp->old_metrics->w[starting_state & 63] = 0; /* Bias known start state */
   return 0;
 }
 
@@ -172,3 +173,44 @@ int update_viterbi27_blk_port(void *p,unsigned char *syms,int nbits){
   vp->dp = d;
   return 0;
 }
+
+/* Streaming traceback. The decisions are treated as a ring of ringsize
+ * entries ending at the current one. Starting from endstate, or from the
+ * best state if endstate is negative, pass over the newest skip decisions
+ * and decode the nbits before them. A full ring wraps back to the start.
+ * Returns the state the traced path started from
+ */
+int traceback_viterbi27_port(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int ringsize, /* Decisions in the ring */
+      unsigned int skip, /* Decisions to pass over before decoding */
+      unsigned int nbits, /* Number of data bits */
+      int endstate){ /* Starting state, -1 for the best one */
+  struct v27 *vp = p;
+  decision_t *d = vp->decisions;
+  unsigned int i,pos,state;
+
+  if(endstate < 0){
+    unsigned int *m = vp->old_metrics->w;
+
+    endstate = 0;
+    for(i=1;i<64;i++)
+      if((signed int)(m[i] - m[endstate]) < 0)
+	endstate = i;
+  }
+  state = (endstate % 64) << 2;
+  pos = vp->dp - d;
+  for(i=skip+nbits;i-- != 0;){
+    int k;
+
+    pos = (pos == 0 ? ringsize : pos) - 1;
+    k = (d[pos].w[(state>>2)/32] >> ((state>>2)%32)) & 1;
+    state = (state >> 1) | (k << 7);
+    if(i < nbits)
+      data[i>>3] = state;
+  }
+  if(vp->dp == d + ringsize)
+    vp->dp = d;
+  return (state >> 2) & 63;
+}
@@ -4,11 +4,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
-#include <xmmintrin.h>
+#include <emmintrin.h>
 #include "fec.h"
 
 typedef union { unsigned char c[64]; __m128i v[4]; } metric_t;
-typedef union { unsigned long w[2]; unsigned char c[8]; unsigned short s[4]; __m64 v[1];} decision_t;
+typedef union { unsigned int w[2]; unsigned char c[8]; unsigned short s[4];} decision_t;
 union branchtab27 { unsigned char c[32]; __m128i v[2];} Branchtab27_sse2[2];
 static int Init = 0;
 
@@ -34,7 +34,8 @@ int init_viterbi27_sse2(void *p,int starting_state){
   vp->old_metrics = &vp->metrics1;
   vp->new_metrics = &vp->metrics2;
   vp->dp = vp->decisions;
-  vp->old_metrics->c[starting_state & 63] = 0; /* Bias known start state */
+  if(starting_state >= 0)
+    vp->old_metrics->c[starting_state & 63] = 0; /* Bias known start state */
   return 0;
 }
 
@@ -98,11 +99,15 @@ void delete_viterbi27_sse2(void *p){
 }
 
 
-#if 0
-/* This code is turned off because it's slower than my hand-crafted assembler in sse2bfly27.s. But it does work. */
-void update_viterbi27_blk_sse2(void *p,unsigned char *syms,int nbits){
+#ifdef __x86_64__
+/* sse2bfly27.s is 32-bit code, so on x86-64 the same butterflies are done with intrinsics.
+ * This follows the assembler step for step, including the saturating arithmetic
+ * and the normalization threshold, so both produce identical results.
+ */
+int update_viterbi27_blk_sse2(void *p,unsigned char *syms,int nbits){
   struct v27 *vp = p;
   decision_t *d = (decision_t *)vp->dp;
+  __m128i thirtyones = _mm_set1_epi8(31);
 
   while(nbits--){
     __m128i sym0v,sym1v;
@@ -123,20 +128,20 @@ void update_viterbi27_blk_sse2(void *p,unsigned char *syms,int nbits){
        * (I'm *really* starting to like Altivec...)
        */
       metric = _mm_srli_epi16(metric,3);
-      metric = _mm_and_si128(metric,_mm_set1_epi8(31));
-      m_metric = _mm_sub_epi8(_mm_set1_epi8(31),metric);
+      metric = _mm_and_si128(metric,thirtyones);
+      m_metric = _mm_xor_si128(metric,thirtyones);
     
       /* Add branch metrics to path metrics */
-      m0 = _mm_add_epi8(vp->old_metrics->v[i],metric);
-      m3 = _mm_add_epi8(vp->old_metrics->v[2+i],metric);
-      m1 = _mm_add_epi8(vp->old_metrics->v[2+i],m_metric);
-      m2 = _mm_add_epi8(vp->old_metrics->v[i],m_metric);
+      m0 = _mm_adds_epu8(vp->old_metrics->v[i],metric);
+      m3 = _mm_adds_epu8(vp->old_metrics->v[2+i],metric);
+      m1 = _mm_adds_epu8(vp->old_metrics->v[2+i],m_metric);
+      m2 = _mm_adds_epu8(vp->old_metrics->v[i],m_metric);
     
-      /* Compare and select, using modulo arithmetic */
-      decision0 = _mm_cmpgt_epi8(_mm_sub_epi8(m0,m1),_mm_setzero_si128());
-      decision1 = _mm_cmpgt_epi8(_mm_sub_epi8(m2,m3),_mm_setzero_si128());
-      survivor0 = _mm_or_si128(_mm_and_si128(decision0,m1),_mm_andnot_si128(decision0,m0));
-      survivor1 = _mm_or_si128(_mm_and_si128(decision1,m3),_mm_andnot_si128(decision1,m2));
+      /* Find survivors, then compare them with the 1-branch metrics to get decisions */
+      survivor0 = _mm_min_epu8(m0,m1);
+      survivor1 = _mm_min_epu8(m2,m3);
+      decision0 = _mm_cmpeq_epi8(survivor0,m1);
+      decision1 = _mm_cmpeq_epi8(survivor1,m3);
  
       /* Pack each set of decisions into 16 bits */
       d->s[2*i] = _mm_movemask_epi8(_mm_unpacklo_epi8(decision0,decision1));
@@ -147,11 +152,69 @@ void update_viterbi27_blk_sse2(void *p,unsigned char *syms,int nbits){
       vp->new_metrics->v[2*i+1] = _mm_unpackhi_epi8(survivor0,survivor1);
     }
     d++;
+
+    /* See sse2bfly27.s for an explanation of the normalization threshold */
+    if(vp->new_metrics->c[0] > 105){
+      __m128i minv;
+
+      minv = _mm_min_epu8(_mm_min_epu8(vp->new_metrics->v[0],vp->new_metrics->v[1]),
+			  _mm_min_epu8(vp->new_metrics->v[2],vp->new_metrics->v[3]));
+      /* crunch down to single lowest metric */
+      minv = _mm_min_epu8(minv,_mm_srli_si128(minv,8));
+      minv = _mm_min_epu8(minv,_mm_srli_si128(minv,4));
+      minv = _mm_min_epu8(minv,_mm_srli_si128(minv,2));
+      minv = _mm_min_epu8(minv,_mm_srli_si128(minv,1));
+      minv = _mm_set1_epi8(_mm_cvtsi128_si32(minv));
+      for(i=0;i<4;i++)
+	vp->new_metrics->v[i] = _mm_subs_epu8(vp->new_metrics->v[i],minv);
+    }
     /* Swap pointers to old and new metrics */
     tmp = vp->old_metrics;
     vp->old_metrics = vp->new_metrics;
     vp->new_metrics = tmp;
   }
   vp->dp = d;
+  return 0;
 }
 #endif
+
+/* Streaming traceback. The decisions are treated as a ring of ringsize
+ * entries ending at the current one. Starting from endstate, or from the
+ * best state if endstate is negative, pass over the newest skip decisions
+ * and decode the nbits before them. A full ring wraps back to the start.
+ * Returns the state the traced path started from
+ */
+int traceback_viterbi27_sse2(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int ringsize, /* Decisions in the ring */
+      unsigned int skip, /* Decisions to pass over before decoding */
+      unsigned int nbits, /* Number of data bits */
+      int endstate){ /* Starting state, -1 for the best one */
+  struct v27 *vp = p;
+  decision_t *d = vp->decisions;
+  unsigned int i,pos,state;
+
+  if(endstate < 0){
+    unsigned char *m = vp->old_metrics->c;
+
+    endstate = 0;
+    for(i=1;i<64;i++)
+      if(m[i] < m[endstate])
+	endstate = i;
+  }
+  state = (endstate % 64) << 2;
+  pos = vp->dp - d;
+  for(i=skip+nbits;i-- != 0;){
+    int k;
+
+    pos = (pos == 0 ? ringsize : pos) - 1;
+    k = (d[pos].c[(state>>2)/8] >> ((state>>2)%8)) & 1;
+    state = (state >> 1) | (k << 7);
+    if(i < nbits)
+      data[i>>3] = state;
+  }
+  if(vp->dp == d + ringsize)
+    vp->dp = d;
+  return (state >> 2) & 63;
+}
@@ -6,6 +6,8 @@
 #include <memory.h>
 #include "fec.h"
 
+#define PACKCHUNK 256 /* Data bits per piece of packed symbols */
+
 /* Create a new instance of a Viterbi decoder */
 void *create_viterbi29(int len){
   find_cpu_mode();
@@ -23,13 +25,20 @@ void *create_viterbi29(int len){
     return create_viterbi29_mmx(len);
   case SSE:
     return create_viterbi29_sse(len);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
   case SSE2:
+  case SSSE3:
+  case SSE41:
     return create_viterbi29_sse2(len);
+  case AVX2:
+  case AVX512BW:
+    return create_viterbi29_avx2(len);
 #endif
   }
 }
 
-/* Initialize Viterbi decoder for start of new frame */
+/* Initialize Viterbi decoder for start of new frame; starting_state -1 if unknown */
 int init_viterbi29(void *p,int starting_state){
     switch(Cpu_mode){
     case PORT:
@@ -44,8 +53,15 @@ int init_viterbi29(void *p,int starting_state){
       return init_viterbi29_mmx(p,starting_state);
     case SSE:
       return init_viterbi29_sse(p,starting_state);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
     case SSE2:
+    case SSSE3:
+    case SSE41:
       return init_viterbi29_sse2(p,starting_state);
+    case AVX2:
+    case AVX512BW:
+      return init_viterbi29_avx2(p,starting_state);
 #endif
     }
 }
@@ -70,8 +86,50 @@ int chainback_viterbi29(
       return chainback_viterbi29_mmx(p,data,nbits,endstate);
     case SSE:
       return chainback_viterbi29_sse(p,data,nbits,endstate);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
     case SSE2:
+    case SSSE3:
+    case SSE41:
       return chainback_viterbi29_sse2(p,data,nbits,endstate);
+    case AVX2:
+    case AVX512BW:
+      return chainback_viterbi29_avx2(p,data,nbits,endstate);
+#endif
+    }
+}
+
+/* Streaming traceback through a ring of decisions, see update_viterbi29_stream() */
+int traceback_viterbi29(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int ringsize, /* Decisions in the ring */
+      unsigned int skip, /* Decisions to pass over before decoding */
+      unsigned int nbits, /* Number of data bits */
+      int endstate){ /* Starting state, -1 for the best one */
+
+    switch(Cpu_mode){
+    case PORT:
+    default:
+      return traceback_viterbi29_port(p,data,ringsize,skip,nbits,endstate);
+#ifdef __VEC__
+    case ALTIVEC:
+      return traceback_viterbi29_av(p,data,ringsize,skip,nbits,endstate);
+#endif
+#ifdef __i386__
+    case MMX:
+      return traceback_viterbi29_mmx(p,data,ringsize,skip,nbits,endstate);
+    case SSE:
+      return traceback_viterbi29_sse(p,data,ringsize,skip,nbits,endstate);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
+    case SSE2:
+    case SSSE3:
+    case SSE41:
+      return traceback_viterbi29_sse2(p,data,ringsize,skip,nbits,endstate);
+    case AVX2:
+    case AVX512BW:
+      return traceback_viterbi29_avx2(p,data,ringsize,skip,nbits,endstate);
 #endif
     }
 }
@@ -95,9 +153,17 @@ void delete_viterbi29(void *p){
     case SSE:
       delete_viterbi29_sse(p);
       break;
+#endif
+#if defined(__i386__) || defined(__x86_64__)
     case SSE2:
+    case SSSE3:
+    case SSE41:
       delete_viterbi29_sse2(p);
       break;
+    case AVX2:
+    case AVX512BW:
+      delete_viterbi29_avx2(p);
+      break;
 #endif
     }
 }
@@ -120,8 +186,210 @@ int update_viterbi29_blk(void *p,unsigned char syms[],int nbits){
       return update_viterbi29_blk_mmx(p,syms,nbits);
     case SSE:
       return update_viterbi29_blk_sse(p,syms,nbits);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
     case SSE2:
+    case SSSE3:
+    case SSE41:
       return update_viterbi29_blk_sse2(p,syms,nbits);
+    case AVX2:
+    case AVX512BW:
+      return update_viterbi29_blk_avx2(p,syms,nbits);
 #endif
     }
 }
+
+/* Update decoder with packed symbols of symbits bits each (1 for hard
+ * decisions), as from pack_syms(). They're expanded a few hundred bits
+ * at a time into a buffer that stays in L1 cache, right ahead of the
+ * branch metric computation, so memory only sees the packed stream.
+ * Returns the sum of what update_viterbi29_blk() returned, or -1 for a bad symbits
+ */
+int update_viterbi29_blk_packed(void *p,const unsigned char *packed,int nbits,int symbits){
+  unsigned char syms[2*PACKCHUNK];
+  int n,r = 0;
+
+  if(symbits < 1 || symbits > 8)
+    return -1;
+  while(nbits > 0){
+    n = nbits < PACKCHUNK ? nbits : PACKCHUNK;
+    unpack_syms(syms,packed,2*n,symbits);
+    r += update_viterbi29_blk(p,syms,n);
+    packed += 2*PACKCHUNK*symbits/8; /* Only a last partial chunk isn't byte aligned */
+    nbits -= n;
+  }
+  return r;
+}
+
+/* Streaming decoding of an unframed symbol stream. The block decoder's
+ * decisions are used as a ring of 2*depth entries; every depth bits, the
+ * decoder traces back depth bits from the best state and releases the
+ * depth bits before that
+ */
+struct v29stream {
+  void *vp;              /* Block decoder holding the metrics and decision ring */
+  unsigned int depth;    /* Traceback depth, also the bits released at a time */
+  unsigned int ringsize; /* Decisions in the ring */
+  unsigned int pos;      /* Ring index of the next decision */
+  int fill;              /* Decisions not yet released, less the 8 that only cover the start state */
+};
+
+/* Create a streaming decoder with the given traceback depth in bits,
+ * rounded up to a multiple of 8. About 5 constraint lengths is enough
+ */
+void *create_viterbi29_stream(int depth){
+  struct v29stream *sp;
+
+  if(depth < 8)
+    depth = 8;
+  if((sp = (struct v29stream *)malloc(sizeof(struct v29stream))) == NULL)
+    return NULL;
+  sp->depth = (depth + 7) & ~7;
+  sp->ringsize = 2*sp->depth;
+  /* The block decoder allocates room for its 8-bit tail too */
+  if((sp->vp = create_viterbi29(sp->ringsize - 8)) == NULL){
+    free(sp);
+    return NULL;
+  }
+  init_viterbi29_stream(sp,0);
+  return sp;
+}
+
+/* Initialize a streaming decoder for the start of a new stream */
+int init_viterbi29_stream(void *p,int starting_state){
+  struct v29stream *sp = p;
+
+  sp->pos = 0;
+  sp->fill = -8;
+  return init_viterbi29(sp->vp,starting_state);
+}
+
+/* Decode nbits worth of symbols, releasing decoded data as it becomes final.
+ * data must have room for (nbits + depth)/8 + 1 bytes. Returns the number
+ * of bits written to data, always a multiple of 8
+ */
+int update_viterbi29_stream(void *p,unsigned char *syms,int nbits,unsigned char *data){
+  struct v29stream *sp = p;
+  int n,out = 0;
+
+  while(nbits > 0){
+    /* Stop at the next release and at the end of the ring */
+    n = nbits;
+    if(sp->fill < (int)sp->ringsize && n > (int)sp->ringsize - sp->fill)
+      n = sp->ringsize - sp->fill;
+    if(n > (int)(sp->ringsize - sp->pos))
+      n = sp->ringsize - sp->pos;
+
+    update_viterbi29_blk(sp->vp,syms,n);
+    syms += 2*n;
+    nbits -= n;
+    sp->pos += n;
+    sp->fill += n;
+
+    if(sp->fill == (int)sp->ringsize){
+      /* Release the oldest depth bits */
+      traceback_viterbi29(sp->vp,data+out/8,sp->ringsize,sp->depth,sp->depth,-1);
+      out += sp->depth;
+      sp->fill -= sp->depth;
+    } else if(sp->pos == sp->ringsize)
+      traceback_viterbi29(sp->vp,NULL,sp->ringsize,0,0,0); /* Just wrap the ring */
+    if(sp->pos == sp->ringsize)
+      sp->pos = 0;
+  }
+  return out;
+}
+
+/* Release everything still held, tracing back from endstate if the
+ * stream ended with a tail, or from the best state if endstate is -1.
+ * data must have room for 2*depth/8 bytes. Returns the number of bits written
+ */
+int flush_viterbi29_stream(void *p,unsigned char *data,int endstate){
+  struct v29stream *sp = p;
+  int n;
+
+  if(sp->fill <= 0)
+    return 0;
+  n = sp->fill;
+  traceback_viterbi29(sp->vp,data,sp->ringsize,0,n,endstate);
+  sp->fill = 0;
+  return n;
+}
+
+/* Delete a streaming decoder */
+void delete_viterbi29_stream(void *p){
+  struct v29stream *sp = p;
+
+  if(sp != NULL){
+    delete_viterbi29(sp->vp);
+    free(sp);
+  }
+}
+
+/* Correlation of a tail-biting frame's symbols with the ones data would produce */
+static long tailbite_metric29(const unsigned char *data,const unsigned char *syms,int nbits){
+  unsigned int sr;
+  long metric = 0;
+  int i;
+
+  /* The encoder starts with the last 8 data bits */
+  sr = 0;
+  for(i=nbits-8;i<nbits;i++)
+    sr = (sr << 1) | ((data[i>>3] >> (7-(i&7))) & 1);
+  for(i=0;i<nbits;i++){
+    sr = (sr << 1) | ((data[i>>3] >> (7-(i&7))) & 1);
+    metric += parity(sr & V29POLYA) ? syms[0] : 255 - syms[0];
+    metric += parity(sr & V29POLYB) ? syms[1] : 255 - syms[1];
+    syms += 2;
+  }
+  return metric;
+}
+
+/* Tail-biting frames: the encoder starts in the state its last 8 data bits
+ * leave it in, so no tail is sent. Decode with the wrap-around Viterbi
+ * algorithm: start with all states equal and run the frame through the
+ * decoder again and again, each pass starting from the last one's path
+ * metrics, until the best path starts and ends in the same state. If
+ * maxpasses run out first, take the best of the last pass's survivors that
+ * does. vp must have been created for at least nbits bits, and data must have
+ * room for (nbits+7)/8 bytes. Returns the number of passes, or -1 if no
+ * tail-biting path turned up at all; data then holds the last pass's best path
+ */
+int tailbite_viterbi29(void *vp,unsigned char *data,unsigned char *syms,int nbits,int maxpasses){
+  unsigned char *trial;
+  long metric,best;
+  int pass,state,start,end;
+
+  if(nbits < 8 || maxpasses < 1)
+    return -1;
+  init_viterbi29(vp,-1);
+  for(pass=1;pass<=maxpasses;pass++){
+    /* Each decision settles the bit 8 before the one just decoded, so
+     * start the pass 8 bits in to make the decisions line up with the data
+     */
+    update_viterbi29_blk(vp,syms+2*8,nbits-8);
+    update_viterbi29_blk(vp,syms,8);
+    /* Find the best state, then trace back from it to where its path
+     * started. That also wraps the decisions for the next pass
+     */
+    end = traceback_viterbi29(vp,NULL,nbits,0,0,-1);
+    start = traceback_viterbi29(vp,data,nbits,0,nbits,end);
+    if(start == end)
+      return pass;
+  }
+  /* Frames that keep flipping between paths never settle on their own.
+   * Score every survivor that bites its own tail and keep the best
+   */
+  if((trial = malloc((nbits+7)/8)) == NULL)
+    return -1;
+  best = -1;
+  for(state=0;state<256;state++){
+    if(traceback_viterbi29(vp,trial,nbits,0,nbits,state) != state)
+      continue;
+    if((metric = tailbite_metric29(trial,syms,nbits)) > best){
+      best = metric;
+      memcpy(data,trial,(nbits+7)/8);
+    }
+  }
+  free(trial);
+  return best >= 0 ? maxpasses : -1;
+}
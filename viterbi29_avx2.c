@@ -0,0 +1,224 @@
+/* K=9 r=1/2 Viterbi decoder for x86 AVX2
+ * Copyright 2026, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <immintrin.h>
+#include "fec.h"
+
+typedef union { unsigned char c[256]; __m256i v[8];} metric_t;
+typedef union { unsigned int w[8]; unsigned char c[32];} decision_t;
+
+static union branchtab29 { unsigned char c[128]; __m256i v[4]; } Branchtab29_avx2[2];
+static int Init = 0;
+
+/* State info for instance of Viterbi decoder */
+struct v29 {
+  metric_t metrics1; /* path metric buffer 1 */
+  metric_t metrics2; /* path metric buffer 2 */
+  decision_t *dp;          /* Pointer to current decision */
+  metric_t *old_metrics,*new_metrics; /* Pointers to path metrics, swapped on every bit */
+  decision_t *decisions;   /* Beginning of decisions for block */
+};
+
+/* Initialize Viterbi decoder for start of new frame */
+int init_viterbi29_avx2(void *p,int starting_state){
+  struct v29 *vp = p;
+  int i;
+
+  for(i=0;i<256;i++)
+    vp->metrics1.c[i] = 63;
+
+  vp->old_metrics = &vp->metrics1;
+  vp->new_metrics = &vp->metrics2;
+  vp->dp = vp->decisions;
+  if(starting_state >= 0)
+    vp->old_metrics->c[starting_state & 255] = 0; /* Bias known start state */
+  return 0;
+}
+
+/* Create a new instance of a Viterbi decoder */
+void *create_viterbi29_avx2(int len){
+  void *p;
+  struct v29 *vp;
+  int state;
+
+  if(!Init){
+    /* Initialize branch tables */
+    for(state=0;state < 128;state++){
+      Branchtab29_avx2[0].c[state] = parity((2*state) & V29POLYA) ? 255:0;
+      Branchtab29_avx2[1].c[state] = parity((2*state) & V29POLYB) ? 255:0;
+    }
+    Init++;
+  }
+  /* The metrics must be 32-byte aligned for AVX2, more than malloc() promises */
+  if(posix_memalign(&p,sizeof(__m256i),sizeof(struct v29)))
+    return NULL;
+  vp = (struct v29 *)p;
+  if((vp->decisions = (decision_t *)malloc((len+8)*sizeof(decision_t))) == NULL){
+    free(vp);
+    return NULL;
+  }
+  init_viterbi29_avx2(vp,0);
+  return vp;
+}
+
+
+/* Viterbi chainback */
+int chainback_viterbi29_avx2(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int nbits, /* Number of data bits */
+      unsigned int endstate){ /* Terminal encoder state */
+  struct v29 *vp = p;
+  decision_t *d = vp->decisions;
+
+  endstate %= 256;
+
+  /* The store into data[] only needs to be done every 8 bits.
+   * But this avoids a conditional branch, and the writes will
+   * combine in the cache anyway
+   */
+  d += 8; /* Look past tail */
+  while(nbits-- != 0){
+    int k;
+
+    k = (d[nbits].c[endstate/8] >> (endstate%8)) & 1;
+    data[nbits>>3] = endstate = (endstate >> 1) | (k << 7);
+  }
+  return 0;
+}
+
+
+/* Delete instance of a Viterbi decoder */
+void delete_viterbi29_avx2(void *p){
+  struct v29 *vp = p;
+
+  if(vp != NULL){
+    free(vp->decisions);
+    free(vp);
+  }
+}
+
+/* Update decoder with a block of demodulated symbols
+ * Note that nbits is the number of decoded data bits, not the number
+ * of symbols!
+ */
+int update_viterbi29_blk_avx2(void *p,unsigned char *syms,int nbits){
+  struct v29 *vp = p;
+  decision_t *d = vp->dp;
+  __m256i thirtyones = _mm256_set1_epi8(31);
+
+  while(nbits--){
+    __m256i sym0v,sym1v;
+    void *tmp;
+    int i;
+
+    /* Splat the 0th symbol across sym0v, the 1st symbol across sym1v */
+    sym0v = _mm256_set1_epi8(syms[0]);
+    sym1v = _mm256_set1_epi8(syms[1]);
+    syms += 2;
+
+    /* Each pass does 32 butterflies, twice as many as sse2bfly29.s */
+    for(i=0;i<4;i++){
+      __m256i metric,m_metric,m0,m1,m2,m3,survivor0,survivor1,decision0,decision1,lo,hi;
+
+      /* Form 5-bit branch metrics */
+      metric = _mm256_avg_epu8(_mm256_xor_si256(Branchtab29_avx2[0].v[i],sym0v),
+			       _mm256_xor_si256(Branchtab29_avx2[1].v[i],sym1v));
+      metric = _mm256_and_si256(_mm256_srli_epi16(metric,3),thirtyones);
+      m_metric = _mm256_xor_si256(metric,thirtyones);
+
+      /* Add branch metrics to path metrics */
+      m0 = _mm256_adds_epu8(vp->old_metrics->v[i],metric);
+      m3 = _mm256_adds_epu8(vp->old_metrics->v[4+i],metric);
+      m1 = _mm256_adds_epu8(vp->old_metrics->v[4+i],m_metric);
+      m2 = _mm256_adds_epu8(vp->old_metrics->v[i],m_metric);
+
+      /* Find survivors and decisions */
+      survivor0 = _mm256_min_epu8(m0,m1);
+      survivor1 = _mm256_min_epu8(m2,m3);
+      decision0 = _mm256_cmpeq_epi8(survivor0,m1);
+      decision1 = _mm256_cmpeq_epi8(survivor1,m3);
+
+      /* Interleave within lanes, then swap the middle lanes back into state order */
+      lo = _mm256_unpacklo_epi8(decision0,decision1);
+      hi = _mm256_unpackhi_epi8(decision0,decision1);
+      d->w[2*i] = _mm256_movemask_epi8(_mm256_permute2x128_si256(lo,hi,0x20));
+      d->w[2*i+1] = _mm256_movemask_epi8(_mm256_permute2x128_si256(lo,hi,0x31));
+
+      lo = _mm256_unpacklo_epi8(survivor0,survivor1);
+      hi = _mm256_unpackhi_epi8(survivor0,survivor1);
+      vp->new_metrics->v[2*i] = _mm256_permute2x128_si256(lo,hi,0x20);
+      vp->new_metrics->v[2*i+1] = _mm256_permute2x128_si256(lo,hi,0x31);
+    }
+    /* Normalize with the same threshold as sse2bfly29.s */
+    if(vp->new_metrics->c[0] > 50){
+      __m256i minv;
+      __m128i t;
+
+      minv = vp->new_metrics->v[0];
+      for(i=1;i<8;i++)
+	minv = _mm256_min_epu8(minv,vp->new_metrics->v[i]);
+      t = _mm_min_epu8(_mm256_castsi256_si128(minv),_mm256_extracti128_si256(minv,1));
+      t = _mm_min_epu8(t,_mm_srli_si128(t,8));
+      t = _mm_min_epu8(t,_mm_srli_si128(t,4));
+      t = _mm_min_epu8(t,_mm_srli_si128(t,2));
+      t = _mm_min_epu8(t,_mm_srli_si128(t,1));
+      minv = _mm256_broadcastb_epi8(t);
+      for(i=0;i<8;i++)
+	vp->new_metrics->v[i] = _mm256_subs_epu8(vp->new_metrics->v[i],minv);
+    }
+    d++;
+    /* Swap pointers to old and new metrics */
+    tmp = vp->old_metrics;
+    vp->old_metrics = vp->new_metrics;
+    vp->new_metrics = tmp;
+  }
+  vp->dp = d;
+  return 0;
+}
+
+/* Streaming traceback. The decisions are treated as a ring of ringsize
+ * entries ending at the current one. Starting from endstate, or from the
+ * best state if endstate is negative, pass over the newest skip decisions
+ * and decode the nbits before them. A full ring wraps back to the start.
+ * Returns the state the traced path started from
+ */
+int traceback_viterbi29_avx2(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int ringsize, /* Decisions in the ring */
+      unsigned int skip, /* Decisions to pass over before decoding */
+      unsigned int nbits, /* Number of data bits */
+      int endstate){ /* Starting state, -1 for the best one */
+  struct v29 *vp = p;
+  decision_t *d = vp->decisions;
+  unsigned int i,pos,state;
+
+  if(endstate < 0){
+    unsigned char *m = vp->old_metrics->c;
+
+    endstate = 0;
+    for(i=1;i<256;i++)
+      if(m[i] < m[endstate])
+	endstate = i;
+  }
+  state = endstate % 256;
+  pos = vp->dp - d;
+  for(i=skip+nbits;i-- != 0;){
+    int k;
+
+    pos = (pos == 0 ? ringsize : pos) - 1;
+    k = (d[pos].c[state/8] >> (state%8)) & 1;
+    state = (state >> 1) | (k << 7);
+    if(i < nbits)
+      data[i>>3] = state;
+  }
+  if(vp->dp == d + ringsize)
+    vp->dp = d;
+  return state & 255;
+}
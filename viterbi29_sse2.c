@@ -9,9 +9,9 @@
 #include "fec.h"
 
 typedef union { unsigned char c[256]; __m128i v[16];} metric_t;
-typedef union { unsigned long w[8]; unsigned char c[32];} decision_t;
+typedef union { unsigned int w[8]; unsigned short s[16]; unsigned char c[32];} decision_t;
 
-union branchtab29 { unsigned char c[128]; } Branchtab29_sse2[2];
+union branchtab29 { unsigned char c[128]; __m128i v[8]; } Branchtab29_sse2[2];
 static int Init = 0;
 
 /* State info for instance of Viterbi decoder
@@ -36,7 +36,8 @@ int init_viterbi29_sse2(void *p,int starting_state){
   vp->old_metrics = &vp->metrics1;
   vp->new_metrics = &vp->metrics2;
   vp->dp = vp->decisions;
-  vp->old_metrics->c[starting_state & 255] = 0; /* Bias known start state */
+  if(starting_state >= 0)
+    vp->old_metrics->c[starting_state & 255] = 0; /* Bias known start state */
   return 0;
 }
 
@@ -98,3 +99,121 @@ void delete_viterbi29_sse2(void *p){
     free(vp);
   }
 }
+
+#ifdef __x86_64__
+/* sse2bfly29.s is 32-bit code, so on x86-64 the same butterflies are done with intrinsics.
+ * This follows the assembler step for step, including the saturating arithmetic
+ * and the normalization threshold, so both produce identical results.
+ */
+int update_viterbi29_blk_sse2(void *p,unsigned char *syms,int nbits){
+  struct v29 *vp = p;
+  decision_t *d = (decision_t *)vp->dp;
+  __m128i thirtyones = _mm_set1_epi8(31);
+
+  while(nbits--){
+    __m128i sym0v,sym1v;
+    void *tmp;
+    int i;
+
+    /* Splat the 0th symbol across sym0v, the 1st symbol across sym1v */
+    sym0v = _mm_set1_epi8(syms[0]);
+    sym1v = _mm_set1_epi8(syms[1]);
+    syms += 2;
+
+    /* Each pass does 16 butterflies in parallel */
+    for(i=0;i<8;i++){
+      __m128i decision0,decision1,metric,m_metric,m0,m1,m2,m3,survivor0,survivor1;
+
+      /* Form branch metrics */
+      metric = _mm_avg_epu8(_mm_xor_si128(Branchtab29_sse2[0].v[i],sym0v),_mm_xor_si128(Branchtab29_sse2[1].v[i],sym1v));
+      metric = _mm_and_si128(_mm_srli_epi16(metric,3),thirtyones);
+      m_metric = _mm_xor_si128(metric,thirtyones);
+
+      /* Add branch metrics to path metrics */
+      m0 = _mm_adds_epu8(vp->old_metrics->v[i],metric);
+      m3 = _mm_adds_epu8(vp->old_metrics->v[8+i],metric);
+      m1 = _mm_adds_epu8(vp->old_metrics->v[8+i],m_metric);
+      m2 = _mm_adds_epu8(vp->old_metrics->v[i],m_metric);
+
+      /* Find survivors, then compare them with the 1-branch metrics to get decisions */
+      survivor0 = _mm_min_epu8(m0,m1);
+      survivor1 = _mm_min_epu8(m2,m3);
+      decision0 = _mm_cmpeq_epi8(survivor0,m1);
+      decision1 = _mm_cmpeq_epi8(survivor1,m3);
+
+      /* Interleave and store decisions */
+      d->s[2*i] = _mm_movemask_epi8(_mm_unpacklo_epi8(decision0,decision1));
+      d->s[2*i+1] = _mm_movemask_epi8(_mm_unpackhi_epi8(decision0,decision1));
+
+      /* Interleave and store surviving metrics */
+      vp->new_metrics->v[2*i] = _mm_unpacklo_epi8(survivor0,survivor1);
+      vp->new_metrics->v[2*i+1] = _mm_unpackhi_epi8(survivor0,survivor1);
+    }
+    d++;
+
+    /* See if we have to normalize */
+    if(vp->new_metrics->c[0] > 50){
+      __m128i minv;
+
+      minv = vp->new_metrics->v[0];
+      for(i=1;i<16;i++)
+	minv = _mm_min_epu8(minv,vp->new_metrics->v[i]);
+      /* crunch down to single lowest metric */
+      minv = _mm_min_epu8(minv,_mm_srli_si128(minv,8));
+      minv = _mm_min_epu8(minv,_mm_srli_si128(minv,4));
+      minv = _mm_min_epu8(minv,_mm_srli_si128(minv,2));
+      minv = _mm_min_epu8(minv,_mm_srli_si128(minv,1));
+      minv = _mm_set1_epi8(_mm_cvtsi128_si32(minv));
+      for(i=0;i<16;i++)
+	vp->new_metrics->v[i] = _mm_subs_epu8(vp->new_metrics->v[i],minv);
+    }
+    /* Swap pointers to old and new metrics */
+    tmp = vp->old_metrics;
+    vp->old_metrics = vp->new_metrics;
+    vp->new_metrics = tmp;
+  }
+  vp->dp = d;
+  return 0;
+}
+#endif
+
+/* Streaming traceback. The decisions are treated as a ring of ringsize
+ * entries ending at the current one. Starting from endstate, or from the
+ * best state if endstate is negative, pass over the newest skip decisions
+ * and decode the nbits before them. A full ring wraps back to the start.
+ * Returns the state the traced path started from
+ */
+int traceback_viterbi29_sse2(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int ringsize, /* Decisions in the ring */
+      unsigned int skip, /* Decisions to pass over before decoding */
+      unsigned int nbits, /* Number of data bits */
+      int endstate){ /* Starting state, -1 for the best one */
+  struct v29 *vp = p;
+  decision_t *d = vp->decisions;
+  unsigned int i,pos,state;
+
+  if(endstate < 0){
+    unsigned char *m = vp->old_metrics->c;
+
+    endstate = 0;
+    for(i=1;i<256;i++)
+      if(m[i] < m[endstate])
+	endstate = i;
+  }
+  state = endstate % 256;
+  pos = vp->dp - d;
+  for(i=skip+nbits;i-- != 0;){
+    int k;
+
+    pos = (pos == 0 ? ringsize : pos) - 1;
+    k = (d[pos].c[state/8] >> (state%8)) & 1;
+    state = (state >> 1) | (k << 7);
+    if(i < nbits)
+      data[i>>3] = state;
+  }
+  if(vp->dp == d + ringsize)
+    vp->dp = d;
+  return state & 255;
+}
@@ -6,6 +6,8 @@
 #include <memory.h>
 #include "fec.h"
 
+#define PACKCHUNK 256 /* Data bits per piece of packed symbols */
+
 /* Create a new instance of a Viterbi decoder */
 void *create_viterbi615(int len){
 
@@ -24,7 +26,13 @@ void *create_viterbi615(int len){
     return create_viterbi615_mmx(len);
   case SSE:
     return create_viterbi615_sse(len);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
   case SSE2:
+  case SSSE3:
+  case SSE41:
+  case AVX2:
+  case AVX512BW:
     return create_viterbi615_sse2(len);
 #endif
   }
@@ -45,7 +53,13 @@ int init_viterbi615(void *p,int starting_state){
       return init_viterbi615_mmx(p,starting_state);
     case SSE:
       return init_viterbi615_sse(p,starting_state);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
     case SSE2:
+    case SSSE3:
+    case SSE41:
+    case AVX2:
+    case AVX512BW:
       return init_viterbi615_sse2(p,starting_state);
 #endif
     }
@@ -71,12 +85,52 @@ int chainback_viterbi615(
       return chainback_viterbi615_mmx(p,data,nbits,endstate);
     case SSE:
       return chainback_viterbi615_sse(p,data,nbits,endstate);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
     case SSE2:
+    case SSSE3:
+    case SSE41:
+    case AVX2:
+    case AVX512BW:
       return chainback_viterbi615_sse2(p,data,nbits,endstate);
 #endif
     }
 }
 
+/* Streaming traceback through a ring of decisions, see update_viterbi615_stream() */
+int traceback_viterbi615(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int ringsize, /* Decisions in the ring */
+      unsigned int skip, /* Decisions to pass over before decoding */
+      unsigned int nbits, /* Number of data bits */
+      int endstate){ /* Starting state, -1 for the best one */
+
+    switch(Cpu_mode){
+    case PORT:
+    default:
+      return traceback_viterbi615_port(p,data,ringsize,skip,nbits,endstate);
+#ifdef __VEC__
+    case ALTIVEC:
+      return traceback_viterbi615_av(p,data,ringsize,skip,nbits,endstate);
+#endif
+#ifdef __i386__
+    case MMX:
+      return traceback_viterbi615_mmx(p,data,ringsize,skip,nbits,endstate);
+    case SSE:
+      return traceback_viterbi615_sse(p,data,ringsize,skip,nbits,endstate);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
+    case SSE2:
+    case SSSE3:
+    case SSE41:
+    case AVX2:
+    case AVX512BW:
+      return traceback_viterbi615_sse2(p,data,ringsize,skip,nbits,endstate);
+#endif
+    }
+}
+
 /* Delete instance of a Viterbi decoder */
 void delete_viterbi615(void *p){
     switch(Cpu_mode){
@@ -96,7 +150,13 @@ void delete_viterbi615(void *p){
     case SSE:
       delete_viterbi615_sse(p);
       break;
+#endif
+#if defined(__i386__) || defined(__x86_64__)
     case SSE2:
+    case SSSE3:
+    case SSE41:
+    case AVX2:
+    case AVX512BW:
       delete_viterbi615_sse2(p);
       break;
 #endif
@@ -121,9 +181,141 @@ int update_viterbi615_blk(void *p,unsigned char syms[],int nbits){
       return update_viterbi615_blk_mmx(p,syms,nbits);
     case SSE:
       return update_viterbi615_blk_sse(p,syms,nbits);
+#endif
+#if defined(__i386__) || defined(__x86_64__)
     case SSE2:
+    case SSSE3:
+    case SSE41:
+    case AVX2:
+    case AVX512BW:
       return update_viterbi615_blk_sse2(p,syms,nbits);
 #endif
     }
 }
 
+/* Update decoder with packed symbols of symbits bits each (1 for hard
+ * decisions), as from pack_syms(). They're expanded a few hundred bits
+ * at a time into a buffer that stays in L1 cache, right ahead of the
+ * branch metric computation, so memory only sees the packed stream.
+ * Returns the sum of what update_viterbi615_blk() returned, or -1 for a bad symbits
+ */
+int update_viterbi615_blk_packed(void *p,const unsigned char *packed,int nbits,int symbits){
+  unsigned char syms[6*PACKCHUNK];
+  int n,r = 0;
+
+  if(symbits < 1 || symbits > 8)
+    return -1;
+  while(nbits > 0){
+    n = nbits < PACKCHUNK ? nbits : PACKCHUNK;
+    unpack_syms(syms,packed,6*n,symbits);
+    r += update_viterbi615_blk(p,syms,n);
+    packed += 6*PACKCHUNK*symbits/8; /* Only a last partial chunk isn't byte aligned */
+    nbits -= n;
+  }
+  return r;
+}
+
+
+/* Streaming decoding of an unframed symbol stream. The block decoder's
+ * decisions are used as a ring of 2*depth entries; every depth bits, the
+ * decoder traces back depth bits from the best state and releases the
+ * depth bits before that
+ */
+struct v615stream {
+  void *vp;              /* Block decoder holding the metrics and decision ring */
+  unsigned int depth;    /* Traceback depth, also the bits released at a time */
+  unsigned int ringsize; /* Decisions in the ring */
+  unsigned int pos;      /* Ring index of the next decision */
+  int fill;              /* Decisions not yet released, less the 14 that only cover the start state */
+};
+
+/* Create a streaming decoder with the given traceback depth in bits,
+ * rounded up to a multiple of 8. About 5 constraint lengths is enough
+ */
+void *create_viterbi615_stream(int depth){
+  struct v615stream *sp;
+
+  if(depth < 8)
+    depth = 8;
+  if((sp = (struct v615stream *)malloc(sizeof(struct v615stream))) == NULL)
+    return NULL;
+  sp->depth = (depth + 7) & ~7;
+  sp->ringsize = 2*sp->depth;
+  /* The block decoder allocates room for its 14-bit tail too */
+  if((sp->vp = create_viterbi615(sp->ringsize - 14)) == NULL){
+    free(sp);
+    return NULL;
+  }
+  init_viterbi615_stream(sp,0);
+  return sp;
+}
+
+/* Initialize a streaming decoder for the start of a new stream */
+int init_viterbi615_stream(void *p,int starting_state){
+  struct v615stream *sp = p;
+
+  sp->pos = 0;
+  sp->fill = -14;
+  return init_viterbi615(sp->vp,starting_state);
+}
+
+/* Decode nbits worth of symbols, releasing decoded data as it becomes final.
+ * data must have room for (nbits + depth)/8 + 1 bytes. Returns the number
+ * of bits written to data, always a multiple of 8
+ */
+int update_viterbi615_stream(void *p,unsigned char *syms,int nbits,unsigned char *data){
+  struct v615stream *sp = p;
+  int n,out = 0;
+
+  while(nbits > 0){
+    /* Stop at the next release and at the end of the ring */
+    n = nbits;
+    if(sp->fill < (int)sp->ringsize && n > (int)sp->ringsize - sp->fill)
+      n = sp->ringsize - sp->fill;
+    if(n > (int)(sp->ringsize - sp->pos))
+      n = sp->ringsize - sp->pos;
+
+    update_viterbi615_blk(sp->vp,syms,n);
+    syms += 6*n;
+    nbits -= n;
+    sp->pos += n;
+    sp->fill += n;
+
+    if(sp->fill == (int)sp->ringsize){
+      /* Release the oldest depth bits */
+      traceback_viterbi615(sp->vp,data+out/8,sp->ringsize,sp->depth,sp->depth,-1);
+      out += sp->depth;
+      sp->fill -= sp->depth;
+    } else if(sp->pos == sp->ringsize)
+      traceback_viterbi615(sp->vp,NULL,sp->ringsize,0,0,0); /* Just wrap the ring */
+    if(sp->pos == sp->ringsize)
+      sp->pos = 0;
+  }
+  return out;
+}
+
+/* Release everything still held, tracing back from endstate if the
+ * stream ended with a tail, or from the best state if endstate is -1.
+ * data must have room for 2*depth/8 bytes. Returns the number of bits written
+ */
+int flush_viterbi615_stream(void *p,unsigned char *data,int endstate){
+  struct v615stream *sp = p;
+  int n;
+
+  if(sp->fill <= 0)
+    return 0;
+  n = sp->fill;
+  traceback_viterbi615(sp->vp,data,sp->ringsize,0,n,endstate);
+  sp->fill = 0;
+  return n;
+}
+
+/* Delete a streaming decoder */
+void delete_viterbi615_stream(void *p){
+  struct v615stream *sp = p;
+
+  if(sp != NULL){
+    delete_viterbi615(sp->vp);
+    free(sp);
+  }
+}
@@ -141,3 +141,43 @@ int update_viterbi615_blk_port(void *p,unsigned char *syms,int nbits){
   return 0;
 }
 
+
+/* Streaming traceback. The decisions are treated as a ring of ringsize
+ * entries ending at the current one. Starting from endstate, or from the
+ * best state if endstate is negative, pass over the newest skip decisions
+ * and decode the nbits before them. A full ring wraps back to the start
+ */
+int traceback_viterbi615_port(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int ringsize, /* Decisions in the ring */
+      unsigned int skip, /* Decisions to pass over before decoding */
+      unsigned int nbits, /* Number of data bits */
+      int endstate){ /* Starting state, -1 for the best one */
+  struct v615 *vp = p;
+  decision_t *d = (decision_t *)vp->decisions;
+  unsigned int i,pos,state;
+
+  if(endstate < 0){
+    unsigned long *m = vp->old_metrics->w;
+
+    endstate = 0;
+    for(i=1;i<16384;i++)
+      if((signed long)(m[i] - m[endstate]) < 0)
+	endstate = i;
+  }
+  state = endstate % 16384;
+  pos = (decision_t *)vp->dp - d;
+  for(i=skip+nbits;i-- != 0;){
+    int k;
+
+    pos = (pos == 0 ? ringsize : pos) - 1;
+    k = (d[pos].c[state/8] >> (state%8)) & 1;
+    state = (k << 13) | (state >> 1);
+    if(i < nbits)
+      data[i>>3] = state >> 6;
+  }
+  if((decision_t *)vp->dp == d + ringsize)
+    vp->dp = vp->decisions;
+  return 0;
+}
@@ -9,7 +9,7 @@
 #include <limits.h>
 #include "fec.h"
 
-typedef union { unsigned long w[512]; unsigned short s[1024];} decision_t;
+typedef union { unsigned int w[512]; unsigned short s[1024];} decision_t;
 typedef union { signed short s[16384]; __m128i v[2048];} metric_t;
 
 static union branchtab615 { unsigned short s[8192]; __m128i v[1024];} Branchtab615[6];
@@ -193,3 +193,43 @@ int update_viterbi615_blk_sse2(void *p,unsigned char *syms,int nbits){
 }
 
 
+
+/* Streaming traceback. The decisions are treated as a ring of ringsize
+ * entries ending at the current one. Starting from endstate, or from the
+ * best state if endstate is negative, pass over the newest skip decisions
+ * and decode the nbits before them. A full ring wraps back to the start
+ */
+int traceback_viterbi615_sse2(
+      void *p,
+      unsigned char *data, /* Decoded output data */
+      unsigned int ringsize, /* Decisions in the ring */
+      unsigned int skip, /* Decisions to pass over before decoding */
+      unsigned int nbits, /* Number of data bits */
+      int endstate){ /* Starting state, -1 for the best one */
+  struct v615 *vp = p;
+  decision_t *d = (decision_t *)vp->decisions;
+  unsigned int i,pos,state;
+
+  if(endstate < 0){
+    signed short *m = vp->old_metrics->s;
+
+    endstate = 0;
+    for(i=1;i<16384;i++)
+      if(m[i] < m[endstate])
+	endstate = i;
+  }
+  state = endstate % 16384;
+  pos = (decision_t *)vp->dp - d;
+  for(i=skip+nbits;i-- != 0;){
+    int k;
+
+    pos = (pos == 0 ? ringsize : pos) - 1;
+    k = (d[pos].w[state/32] >> (state%32)) & 1;
+    state = (k << 13) | (state >> 1);
+    if(i < nbits)
+      data[i>>3] = state >> 6;
+  }
+  if((decision_t *)vp->dp == d + ringsize)
+    vp->dp = vp->decisions;
+  return 0;
+}
@@ -22,6 +22,9 @@ struct option Options[] = {
   {"ebn0",1,NULL,'e'},
   {"gain",1,NULL,'g'},
   {"verbose",0,NULL,'v'},
+  {"threads",1,NULL,'j'},
+  {"depth",1,NULL,'d'},
+  {"code",1,NULL,'c'},
   {NULL},
 };
 #endif
@@ -53,14 +56,17 @@ int main(int argc,char *argv[]){
   double noise,esn0,ebn0;
   time_t t;
   int badframes=0;
+  int nthreads=1;
+  int depth=0;   // Traceback depth for the streaming decoder, 0 = block decoder
+  const struct conv_code *code = DEFAULT_CODE;
 
   time(&t);
   srandom(t);
   ebn0 = -100;
 #if HAVE_GETOPT_LONG
-  while((d = getopt_long(argc,argv,"l:n:e:g:v",Options,NULL)) != EOF){
+  while((d = getopt_long(argc,argv,"l:n:e:g:vj:d:c:",Options,NULL)) != EOF){
 #else
-  while((d = getopt(argc,argv,"l:n:e:g:v")) != EOF){
+  while((d = getopt(argc,argv,"l:n:e:g:vj:d:c:")) != EOF){
 #endif
     switch(d){
     case 'l':
@@ -78,14 +84,32 @@ int main(int argc,char *argv[]){
     case 'v':
       Verbose++;
       break;
+    case 'j':
+      nthreads = atoi(optarg);
+      break;
+    case 'd':
+      depth = atoi(optarg);
+      break;
+    case 'c':
+      if((code = find_conv_code(optarg)) == NULL){
+	fprintf(stderr,"Unknown code %s\n",optarg);
+	exit(1);
+      }
+      break;
     }
   }
   if(framebits > 8*MAXBYTES){
     fprintf(stderr,"Frame limited to %d bits\n",MAXBYTES*8);
     framebits = MAXBYTES*8;
   }
-  if((vp = create_viterbi224(framebits)) == NULL){
-    printf("create_viterbi224 failed\n");
+  if(depth > 0){
+    // Decisions for only depth+32 bits at a time, however long the frame
+    if((vp = create_viterbi224_stream(depth,32,nthreads,code)) == NULL){
+      printf("create_viterbi224_stream failed\n");
+      exit(1);
+    }
+  } else if((vp = create_viterbi224_mt(framebits,nthreads,code)) == NULL){
+    printf("create_viterbi224_mt failed\n");
     exit(1);
   }
   if(ebn0 != -100){
@@ -98,13 +122,13 @@ int main(int argc,char *argv[]){
 
     for(tr=0;tr<trials;tr++){
       // Encode a frame of random data
-      for(i=0;i<(framebits-K)/8;i++)
+      for(i=0;i<(framebits-code->k)/8;i++)
 	data[i] = random() & 0xff;
 
       for(;i<framebits/8;i++) // leave a tail of 0's
 	data[i] = 0;
 
-      encode(symbols,data,framebits/8);
+      encode_code(code,symbols,data,framebits/8);
 
       // Add noise & scale, build histogram
       for(i=0;i<2*framebits;i++)
@@ -112,9 +136,17 @@ int main(int argc,char *argv[]){
 
       // Decode it, measuring the time
       getrusage(RUSAGE_SELF,&start);
-      init_viterbi224(vp,0);
-      update_viterbi224_blk(vp,symbols,framebits);
-      chainback_viterbi224(vp,decoded_data,framebits,0);
+      if(depth > 0){
+	int n;
+
+	init_viterbi224_stream(vp,0);
+	n = update_viterbi224_stream(vp,symbols,framebits,decoded_data);
+	flush_viterbi224_stream(vp,decoded_data+n/8,0);
+      } else {
+	init_viterbi224(vp,0);
+	update_viterbi224_blk_mt(vp,symbols,framebits);
+	chainback_viterbi224(vp,decoded_data,framebits,0);
+      }
       getrusage(RUSAGE_SELF,&finish);
       extime = finish.ru_utime.tv_sec - start.ru_utime.tv_sec + 1e-6*(finish.ru_utime.tv_usec - start.ru_utime.tv_usec);
 
@@ -165,11 +197,19 @@ int main(int argc,char *argv[]){
     printf("Starting time trials\n");
     getrusage(RUSAGE_SELF,&start);
     for(tr=0;tr < trials;tr++){
+      if(depth > 0){
+	int n;
+
+	init_viterbi224_stream(vp,0);
+	n = update_viterbi224_stream(vp,symbols,framebits,decoded_data);
+	flush_viterbi224_stream(vp,decoded_data+n/8,0);
+	continue;
+      }
       /* Initialize Viterbi decoder */
       init_viterbi224(vp,0);
 
       /* Decode block */
-      update_viterbi224_blk(vp,symbols,framebits);
+      update_viterbi224_blk_mt(vp,symbols,framebits);
 
       /* Do Viterbi chainback */
       chainback_viterbi224(vp,decoded_data,framebits,0);
@@ -180,6 +220,9 @@ int main(int argc,char *argv[]){
 	   framebits,extime);
     printf("decoder speed: %g bits/s\n",trials*framebits/extime);
   }
-  delete_viterbi224(vp);
+  if(depth > 0)
+    delete_viterbi224_stream(vp);
+  else
+    delete_viterbi224(vp);
   exit(0);
 }
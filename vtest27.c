@@ -6,6 +6,7 @@
 #include <time.h>
 #include <math.h>
 #include <memory.h>
+#include <string.h>
 #include <sys/times.h>
 #ifdef HAVE_GETOPT_H
 #include <getopt.h>
@@ -24,6 +25,12 @@ struct option Options[] = {
   {"force-mmx",0,NULL,'m'},
   {"force-sse",0,NULL,'s'},
   {"force-sse2",0,NULL,'t'},
+  {"force-avx2",0,NULL,'x'},
+  {"stream-depth",1,NULL,'d'},
+  {"symbol-bits",1,NULL,'q'},
+  {"tail-biting",1,NULL,'T'},
+  {"puncture",1,NULL,'P'},
+  {"batch",1,NULL,'b'},
   {NULL},
 };
 #endif
@@ -33,20 +40,31 @@ struct option Options[] = {
 
 double Gain = 32.0;
 int Verbose = 0;
+int Depth = 0; /* Traceback depth for the streaming decoder, 0 = block decoder */
+int Symbits = 0; /* Pack symbols to this many bits for the decoder, 0 = don't */
+int Tailbite = 0; /* Maximum wrap-around passes for tail-biting frames, 0 = tailed frames */
+const struct puncture *Punct = NULL; /* Puncture to a higher rate, NULL = don't */
+
+int streamtest(int trials,int framebits,double ebn0);
+int Batch = 0; /* Frames per batch for the batch decoder, 0 = single frame decoder */
+
+int batchtest(int trials,int framebits,double ebn0);
 
 int main(int argc,char *argv[]){
-  int i,d,tr;
-  int sr=0,trials = 10000,errcnt,framebits=2048;
-  long long int tot_errs=0;
-  unsigned char bits[MAXBYTES];
+  int i,d,tr,n;
+  int trials = 10000,errcnt,framebits=2048;
+  long long int tot_errs=0,tot_passes=0;
+  unsigned char bits[MAXBYTES+2];
   unsigned char data[MAXBYTES];
   unsigned char xordata[MAXBYTES];
   unsigned char symbols[8*2*(MAXBYTES+6)];
-  void *vp;
+  unsigned char packed[8*2*(MAXBYTES+6)];
+  void *vp,*enc;
+  void *noise;
   extern char *optarg;
   struct tms start,finish;
   double extime;
-  double gain,esn0,ebn0;
+  double gain,esn0,ebn0,rate;
   time_t t;
   int badframes=0;
 
@@ -54,9 +72,9 @@ int main(int argc,char *argv[]){
   srandom(t);
   ebn0 = -100;
 #if HAVE_GETOPT_LONG
-  while((d = getopt_long(argc,argv,"l:n:te:g:vapmst",Options,NULL)) != EOF){
+  while((d = getopt_long(argc,argv,"l:n:te:g:vapmstxb:d:q:T:P:",Options,NULL)) != EOF){
 #else
-  while((d = getopt(argc,argv,"l:n:te:g:vapmst")) != EOF){
+  while((d = getopt(argc,argv,"l:n:te:g:vapmstxb:d:q:T:P:")) != EOF){
 #endif
     switch(d){
     case 'a':
@@ -74,6 +92,9 @@ int main(int argc,char *argv[]){
     case 't':
       Cpu_mode = SSE2;
       break;
+    case 'x':
+      Cpu_mode = AVX2;
+      break;
     case 'l':
       framebits = atoi(optarg);
       break;
@@ -89,45 +110,110 @@ int main(int argc,char *argv[]){
     case 'v':
       Verbose++;
       break;
+    case 'd':
+      Depth = atoi(optarg);
+      break;
+    case 'q':
+      Symbits = atoi(optarg);
+      break;
+    case 'T':
+      Tailbite = atoi(optarg);
+      break;
+    case 'P':
+      if(strcmp(optarg,"2/3") == 0)
+	Punct = &V27punct23;
+      else if(strcmp(optarg,"3/4") == 0)
+	Punct = &V27punct34;
+      else if(strcmp(optarg,"5/6") == 0)
+	Punct = &V27punct56;
+      else if(strcmp(optarg,"7/8") == 0)
+	Punct = &V27punct78;
+      else {
+	fprintf(stderr,"Puncturing rate must be 2/3, 3/4, 5/6 or 7/8\n");
+	exit(1);
+      }
+      break;
+    case 'b':
+      Batch = atoi(optarg);
+      break;
     }
   }
+  if(Tailbite > 0 && (framebits % 8) != 0){
+    fprintf(stderr,"Tail-biting frames must be a whole number of bytes\n");
+    exit(1);
+  }
   if(framebits > 8*MAXBYTES){
     fprintf(stderr,"Frame limited to %d bits\n",MAXBYTES*8);
     framebits = MAXBYTES*8;
   }
+  if(Depth > 0)
+    exit(streamtest(trials,framebits,ebn0));
+  if(Batch > 0)
+    exit(batchtest(trials,framebits,ebn0));
   if((vp = create_viterbi27(framebits)) == NULL){
     printf("create_viterbi27 failed\n");
     exit(1);
   }
   if(ebn0 != -100){
-    esn0 = ebn0 + 10*log10((double)RATE); /* Es/No in dB */
+    rate = RATE;
+    if(Punct != NULL){
+      /* period data bits go out in however many symbols the pattern keeps */
+      for(i=n=0;i<2*Punct->period;i++)
+	n += Punct->keep[i];
+      rate = (double)Punct->period / n;
+    }
+    esn0 = ebn0 + 10*log10(rate); /* Es/No in dB */
     /* Compute noise voltage. The 0.5 factor accounts for BPSK seeing
      * only half the noise power, and the sqrt() converts power to
      * voltage.
      */
     gain = 1./sqrt(0.5/pow(10.,esn0/10.));
+    noise = init_noise(gain,Gain,127.5,255,random());
+    if((enc = create_encoder27()) == NULL){
+      printf("create_encoder27 failed\n");
+      exit(1);
+    }
     
-    printf("nframes = %d framesize = %d ebn0 = %.2f dB gain = %g\n",trials,framebits,ebn0,Gain);
+    printf("nframes = %d framesize = %d ebn0 = %.2f dB gain = %g rate = %.3f\n",trials,framebits,ebn0,Gain,rate);
     
     for(tr=0;tr<trials;tr++){
-      /* Encode a frame of random data */
-      for(i=0;i<framebits+6;i++){
-	int bit = (i < framebits) ? (random() & 1) : 0;
-	
-	sr = (sr << 1) | bit;
-	bits[i/8] = sr & 0xff;
-	symbols[2*i+0] = addnoise(parity(sr & V27POLYA),gain,Gain,127.5,255);
-	symbols[2*i+1] = addnoise(parity(sr & V27POLYB),gain,Gain,127.5,255);
+      /* Encode a frame of random data, with zeros after it for the tail */
+      memset(bits,0,(framebits+6+7)/8);
+      for(i=0;i<framebits/8;i++)
+	bits[i] = random() & 0xff;
+      if(Tailbite > 0){
+	/* No tail; start the encoder where the end of the frame will leave it */
+	init_encoder(enc,bits[framebits/8-1]);
+	encode_conv(enc,symbols,bits,framebits/8);
+      } else {
+	init_encoder(enc,0);
+	encode_conv(enc,symbols,bits,(framebits+6+7)/8);
       }
+      n = 2*(framebits+6);
+      if(Punct != NULL)
+	n = puncture_syms(symbols,symbols,framebits+6,Punct);
+      addnoise_blk(noise,symbols,symbols,n);
       /* Decode it and make sure we get the right answer */
-      /* Initialize Viterbi decoder */
-      init_viterbi27(vp,0);
+      if(Tailbite > 0){
+	n = tailbite_viterbi27(vp,data,symbols,framebits,Tailbite);
+	tot_passes += n > 0 ? n : Tailbite;
+      } else {
+	/* Initialize Viterbi decoder */
+	init_viterbi27(vp,0);
       
-      /* Decode block */
-      update_viterbi27_blk(vp,symbols,framebits+6);
+	/* Decode block */
+	if(Punct != NULL)
+	  update_viterbi27_blk_punct(vp,symbols,framebits+6,Punct);
+	else if(Symbits != 0){
+	  /* Pass them packed, as from a hard decision or coarse soft decision demod */
+	  pack_syms(packed,symbols,2*(framebits+6),Symbits);
+	  update_viterbi27_blk_packed(vp,packed,framebits+6,Symbits);
+	} else
+	  update_viterbi27_blk(vp,symbols,framebits+6);
       
-      /* Do Viterbi chainback */
-      chainback_viterbi27(vp,data,framebits,0);
+	/* Do Viterbi chainback */
+	chainback_viterbi27(vp,data,framebits,0);
+      }
       errcnt = 0;
       for(i=0;i<framebits/8;i++){
 	int e = Bitcnt[xordata[i] = data[i] ^ bits[i]];
@@ -157,7 +243,9 @@ int main(int argc,char *argv[]){
 	     badframes,tr+1,(double)badframes/(tr+1));
     else
       printf("\n");
-
+    if(Tailbite > 0)
+      printf("average wrap-around passes %.3f\n",(double)tot_passes/trials);
+    free_noise(noise);
   } else {
     /* Do time trials */
     memset(symbols,127,sizeof(symbols));
@@ -181,3 +269,156 @@ int main(int argc,char *argv[]){
   }
   exit(0);
 }
+
+/* Same tests as above, but decoding Batch frames at a time with the batch decoder */
+int batchtest(int trials,int framebits,double ebn0){
+  int i,f,tr,n,errcnt,badframes=0,sr;
+  long long int tot_errs=0;
+  unsigned char **bits,**data,**symbols;
+  int *startstates,*endstates;
+  void *vp;
+  void *noise;
+  struct tms start,finish;
+  double extime,gain,esn0;
+
+  bits = malloc(Batch*sizeof(unsigned char *));
+  data = malloc(Batch*sizeof(unsigned char *));
+  symbols = malloc(Batch*sizeof(unsigned char *));
+  startstates = malloc(Batch*sizeof(int));
+  endstates = malloc(Batch*sizeof(int));
+  for(f=0;f<Batch;f++){
+    bits[f] = malloc((framebits+6)/8+1);
+    data[f] = malloc(framebits/8+1);
+    symbols[f] = malloc(2*(framebits+6));
+  }
+  if((vp = create_viterbi27_batch(Batch,framebits)) == NULL){
+    printf("create_viterbi27_batch failed\n");
+    return 1;
+  }
+  if(ebn0 == -100){
+    /* Do time trials */
+    for(f=0;f<Batch;f++)
+      memset(symbols[f],127,2*(framebits+6));
+    printf("Starting time trials, %d frames per batch\n",Batch);
+    times(&start);
+    for(tr=0;tr < trials;tr += Batch){
+      init_viterbi27_batch(vp,NULL);
+      update_viterbi27_batch(vp,symbols,framebits);
+      for(f=0;f<Batch;f++)
+	chainback_viterbi27_batch(vp,f,data[f],framebits,0);
+    }
+    times(&finish);
+    extime = ((double)(finish.tms_utime-start.tms_utime))/CLOCKS_PER_SEC;
+    printf("Execution time for %d %d-bit frames: %.2f sec\n",tr,
+	   framebits,extime);
+    printf("decoder speed: %g bits/s\n",tr*framebits/extime);
+    return 0;
+  }
+  esn0 = ebn0 + 10*log10((double)RATE); /* Es/No in dB */
+  gain = 1./sqrt(0.5/pow(10.,esn0/10.));
+  noise = init_noise(gain,Gain,127.5,255,random());
+
+  printf("nframes = %d framesize = %d ebn0 = %.2f dB gain = %g batch = %d\n",trials,framebits,ebn0,Gain,Batch);
+  for(tr=0;tr<trials;tr += n){
+    n = trials - tr < Batch ? trials - tr : Batch;
+
+    /* Encode n frames of random data, each with its own start and end state.
+     * The tail bits drive the encoder into the chosen end state.
+     * Any frames beyond n are decoded too, but not checked
+     */
+    for(f=0;f<n;f++){
+      sr = startstates[f] = random() & 63;
+      endstates[f] = random() & 63;
+      for(i=0;i<framebits+6;i++){
+	int bit = (i < framebits) ? (random() & 1) : (endstates[f] >> (framebits+5-i)) & 1;
+
+	sr = (sr << 1) | bit;
+	bits[f][i/8] = sr & 0xff;
+	symbols[f][2*i+0] = parity(sr & V27POLYA);
+	symbols[f][2*i+1] = parity(sr & V27POLYB);
+      }
+      addnoise_blk(noise,symbols[f],symbols[f],2*(framebits+6));
+    }
+    init_viterbi27_batch(vp,startstates);
+    update_viterbi27_batch(vp,symbols,framebits+6);
+    for(f=0;f<n;f++){
+      chainback_viterbi27_batch(vp,f,data[f],framebits,endstates[f]);
+      errcnt = 0;
+      for(i=0;i<framebits/8;i++)
+	errcnt += Bitcnt[data[f][i] ^ bits[f][i]];
+      tot_errs += errcnt;
+      if(errcnt != 0)
+	badframes++;
+    }
+  }
+  printf("BER %lld/%lld (%.3g) FER %d/%d (%.3g)\n",
+	 tot_errs,(long long)framebits*trials,tot_errs/((double)framebits*trials),
+	 badframes,trials,(double)badframes/trials);
+  free_noise(noise);
+  return 0;
+}
+
+/* Decode trials*framebits bits as one continuous stream, framebits at a time,
+ * with the streaming decoder. Only the very end of the stream has a tail
+ */
+int streamtest(int trials,int framebits,double ebn0){
+  long long i,nbits,out = 0,tot_errs = 0;
+  int tr,n,sr = 0;
+  unsigned char *bits,*data,*symbols;
+  void *vp;
+  void *noise;
+  struct tms start,finish;
+  double extime,gain = 0,esn0;
+
+  nbits = (long long)trials * framebits;
+  bits = calloc(nbits/8 + 2,1);
+  data = calloc(nbits/8 + Depth/4 + 2,1);
+  symbols = malloc(2*(framebits+6));
+  if((vp = create_viterbi27_stream(Depth)) == NULL){
+    printf("create_viterbi27_stream failed\n");
+    return 1;
+  }
+  if(ebn0 == -100){
+    /* Do time trials */
+    memset(symbols,127,2*(framebits+6));
+    printf("Starting time trials, traceback depth %d\n",Depth);
+    init_viterbi27_stream(vp,0);
+    times(&start);
+    for(tr=0;tr < trials;tr++)
+      out += update_viterbi27_stream(vp,symbols,framebits,data);
+    times(&finish);
+    extime = ((double)(finish.tms_utime-start.tms_utime))/CLOCKS_PER_SEC;
+    printf("Execution time for %lld bits: %.2f sec\n",nbits,extime);
+    printf("decoder speed: %g bits/s\n",nbits/extime);
+    return 0;
+  }
+  esn0 = ebn0 + 10*log10((double)RATE); /* Es/No in dB */
+  gain = 1./sqrt(0.5/pow(10.,esn0/10.));
+  noise = init_noise(gain,Gain,127.5,255,random());
+  printf("nbits = %lld ebn0 = %.2f dB gain = %g traceback depth = %d\n",nbits,ebn0,Gain,Depth);
+
+  init_viterbi27_stream(vp,0);
+  for(tr=0;tr<trials;tr++){
+    /* Encode the next framebits of the stream; the last piece gets the tail */
+    n = framebits + (tr == trials-1 ? 6 : 0);
+    for(i=0;i<n;i++){
+      int bit = (i < framebits) ? (random() & 1) : 0;
+
+      sr = (sr << 1) | bit;
+      if(i < framebits)
+	bits[((long long)tr*framebits+i)/8] = sr & 0xff;
+      symbols[2*i+0] = parity(sr & V27POLYA);
+      symbols[2*i+1] = parity(sr & V27POLYB);
+    }
+    addnoise_blk(noise,symbols,symbols,2*n);
+    out += update_viterbi27_stream(vp,symbols,n,data+out/8);
+  }
+  out += flush_viterbi27_stream(vp,data+out/8,0);
+  if(out != nbits)
+    printf("released %lld bits, expected %lld\n",out,nbits);
+  for(i=0;i<nbits/8;i++)
+    tot_errs += Bitcnt[data[i] ^ bits[i]];
+  printf("BER %lld/%lld (%.3g)\n",tot_errs,nbits,tot_errs/(double)nbits);
+  free_noise(noise);
+  return 0;
+}
@@ -24,6 +24,10 @@ struct option Options[] = {
   {"force-mmx",0,NULL,'m'},
   {"force-sse",0,NULL,'s'},
   {"force-sse2",0,NULL,'t'},
+  {"force-avx2",0,NULL,'x'},
+  {"stream-depth",1,NULL,'d'},
+  {"symbol-bits",1,NULL,'q'},
+  {"tail-biting",1,NULL,'T'},
   {NULL},
 };
 #endif
@@ -33,16 +37,23 @@ struct option Options[] = {
 
 double Gain = 32.0;
 int Verbose = 0;
+int Depth = 0; /* Traceback depth for the streaming decoder, 0 = block decoder */
+int Symbits = 0; /* Pack symbols to this many bits for the decoder, 0 = don't */
+int Tailbite = 0; /* Maximum wrap-around passes for tail-biting frames, 0 = tailed frames */
+
+int streamtest(int trials,int framebits,double ebn0);
 
 int main(int argc,char *argv[]){
-  int i,d,tr;
-  int sr=0,trials = 10000,errcnt,framebits=2048;
-  long long tot_errs=0;
-  unsigned char bits[MAXBYTES];
+  int i,d,tr,n;
+  int trials = 10000,errcnt,framebits=2048;
+  long long tot_errs=0,tot_passes=0;
+  unsigned char bits[MAXBYTES+2];
   unsigned char data[MAXBYTES];
   unsigned char xordata[MAXBYTES];
   unsigned char symbols[8*2*(MAXBYTES+8)];
-  void *vp;
+  unsigned char packed[8*2*(MAXBYTES+8)];
+  void *vp,*enc;
+  void *noise;
   extern char *optarg;
   struct tms start,finish;
   double extime;
@@ -54,9 +65,9 @@ int main(int argc,char *argv[]){
   srandom(t);
   ebn0 = -100;
 #if HAVE_GETOPT_LONG
-  while((d = getopt_long(argc,argv,"l:n:te:g:vapmst",Options,NULL)) != EOF){
+  while((d = getopt_long(argc,argv,"l:n:te:g:vapmstxd:q:T:",Options,NULL)) != EOF){
 #else
-  while((d = getopt(argc,argv,"l:n:te:g:vapmst")) != EOF){
+  while((d = getopt(argc,argv,"l:n:te:g:vapmstxd:q:T:")) != EOF){
 #endif
     switch(d){
     case 'a':
@@ -74,6 +85,9 @@ int main(int argc,char *argv[]){
     case 't':
       Cpu_mode = SSE2;
       break;
+    case 'x':
+      Cpu_mode = AVX2;
+      break;
     case 'l':
       framebits = atoi(optarg);
       break;
@@ -89,12 +103,27 @@ int main(int argc,char *argv[]){
     case 'v':
       Verbose++;
       break;
+    case 'd':
+      Depth = atoi(optarg);
+      break;
+    case 'q':
+      Symbits = atoi(optarg);
+      break;
+    case 'T':
+      Tailbite = atoi(optarg);
+      break;
     }
   }
+  if(Tailbite > 0 && (framebits % 8) != 0){
+    fprintf(stderr,"Tail-biting frames must be a whole number of bytes\n");
+    exit(1);
+  }
   if(framebits > 8*MAXBYTES){
     fprintf(stderr,"Frame limited to %d bits\n",MAXBYTES*8);
     framebits = MAXBYTES*8;
   }
+  if(Depth > 0)
+    exit(streamtest(trials,framebits,ebn0));
   if((vp = create_viterbi29(framebits)) == NULL){
     printf("create_viterbi29 failed\n");
     exit(1);
@@ -106,28 +135,47 @@ int main(int argc,char *argv[]){
      * voltage.
      */
     gain = 1./sqrt(0.5/pow(10.,esn0/10.));
+    noise = init_noise(gain,Gain,127.5,255,random());
+    if((enc = create_encoder29()) == NULL){
+      printf("create_encoder29 failed\n");
+      exit(1);
+    }
     
     printf("nframes = %d framesize = %d ebn0 = %.2f dB gain = %g\n",trials,framebits,ebn0,Gain);
     
     for(tr=0;tr<trials;tr++){
-      /* Encode a frame of random data */
-      for(i=0;i<framebits+8;i++){
-	int bit = (i < framebits) ? (random() & 1) : 0;
-	
-	sr = (sr << 1) | bit;
-	bits[i/8] = sr & 0xff;
-	symbols[2*i+0] = addnoise(parity(sr & V29POLYA),gain,Gain,127.5,255);
-	symbols[2*i+1] = addnoise(parity(sr & V29POLYB),gain,Gain,127.5,255);
+      /* Encode a frame of random data, with zeros after it for the tail */
+      memset(bits,0,(framebits+8+7)/8);
+      for(i=0;i<framebits/8;i++)
+	bits[i] = random() & 0xff;
+      if(Tailbite > 0){
+	/* No tail; start the encoder where the end of the frame will leave it */
+	init_encoder(enc,bits[framebits/8-1]);
+	encode_conv(enc,symbols,bits,framebits/8);
+      } else {
+	init_encoder(enc,0);
+	encode_conv(enc,symbols,bits,(framebits+8+7)/8);
       }
+      addnoise_blk(noise,symbols,symbols,2*(framebits+8));
       /* Decode it and make sure we get the right answer */
-      /* Initialize Viterbi decoder */
-      init_viterbi29(vp,0);
+      if(Tailbite > 0){
+	n = tailbite_viterbi29(vp,data,symbols,framebits,Tailbite);
+	tot_passes += n > 0 ? n : Tailbite;
+      } else {
+	/* Initialize Viterbi decoder */
+	init_viterbi29(vp,0);
       
-      /* Decode block */
-      update_viterbi29_blk(vp,symbols,framebits+8);
+	/* Decode block */
+	if(Symbits != 0){
+	  /* Pass them packed, as from a hard decision or coarse soft decision demod */
+	  pack_syms(packed,symbols,2*(framebits+8),Symbits);
+	  update_viterbi29_blk_packed(vp,packed,framebits+8,Symbits);
+	} else
+	  update_viterbi29_blk(vp,symbols,framebits+8);
       
-      /* Do Viterbi chainback */
-      chainback_viterbi29(vp,data,framebits,0);
+	/* Do Viterbi chainback */
+	chainback_viterbi29(vp,data,framebits,0);
+      }
       errcnt = 0;
       for(i=0;i<framebits/8;i++){
 	int e = Bitcnt[xordata[i] = data[i] ^ bits[i]];
@@ -157,6 +205,9 @@ int main(int argc,char *argv[]){
 	     badframes,tr+1,(double)badframes/(tr+1));
     else
       printf("\n");
+    if(Tailbite > 0)
+      printf("average wrap-around passes %.3f\n",(double)tot_passes/trials);
+    free_noise(noise);
   } else {
     /* Do time trials */
     memset(symbols,127,sizeof(symbols));
@@ -182,3 +233,68 @@ int main(int argc,char *argv[]){
 }
 
 
+
+/* Decode trials*framebits bits as one continuous stream, framebits at a time,
+ * with the streaming decoder. Only the very end of the stream has a tail
+ */
+int streamtest(int trials,int framebits,double ebn0){
+  long long i,nbits,out = 0,tot_errs = 0;
+  int tr,n,sr = 0;
+  unsigned char *bits,*data,*symbols;
+  void *vp;
+  void *noise;
+  struct tms start,finish;
+  double extime,gain = 0,esn0;
+
+  nbits = (long long)trials * framebits;
+  bits = calloc(nbits/8 + 2,1);
+  data = calloc(nbits/8 + Depth/4 + 2,1);
+  symbols = malloc(2*(framebits+8));
+  if((vp = create_viterbi29_stream(Depth)) == NULL){
+    printf("create_viterbi29_stream failed\n");
+    return 1;
+  }
+  if(ebn0 == -100){
+    /* Do time trials */
+    memset(symbols,127,2*(framebits+8));
+    printf("Starting time trials, traceback depth %d\n",Depth);
+    init_viterbi29_stream(vp,0);
+    times(&start);
+    for(tr=0;tr < trials;tr++)
+      out += update_viterbi29_stream(vp,symbols,framebits,data);
+    times(&finish);
+    extime = ((double)(finish.tms_utime-start.tms_utime))/CLOCKS_PER_SEC;
+    printf("Execution time for %lld bits: %.2f sec\n",nbits,extime);
+    printf("decoder speed: %g bits/s\n",nbits/extime);
+    return 0;
+  }
+  esn0 = ebn0 + 10*log10((double)RATE); /* Es/No in dB */
+  gain = 1./sqrt(0.5/pow(10.,esn0/10.));
+  noise = init_noise(gain,Gain,127.5,255,random());
+  printf("nbits = %lld ebn0 = %.2f dB gain = %g traceback depth = %d\n",nbits,ebn0,Gain,Depth);
+
+  init_viterbi29_stream(vp,0);
+  for(tr=0;tr<trials;tr++){
+    /* Encode the next framebits of the stream; the last piece gets the tail */
+    n = framebits + (tr == trials-1 ? 8 : 0);
+    for(i=0;i<n;i++){
+      int bit = (i < framebits) ? (random() & 1) : 0;
+
+      sr = (sr << 1) | bit;
+      if(i < framebits)
+	bits[((long long)tr*framebits+i)/8] = sr & 0xff;
+      symbols[2*i+0] = parity(sr & V29POLYA);
+      symbols[2*i+1] = parity(sr & V29POLYB);
+    }
+    addnoise_blk(noise,symbols,symbols,2*n);
+    out += update_viterbi29_stream(vp,symbols,n,data+out/8);
+  }
+  out += flush_viterbi29_stream(vp,data+out/8,0);
+  if(out != nbits)
+    printf("released %lld bits, expected %lld\n",out,nbits);
+  for(i=0;i<nbits/8;i++)
+    tot_errs += Bitcnt[data[i] ^ bits[i]];
+  printf("BER %lld/%lld (%.3g)\n",tot_errs,nbits,tot_errs/(double)nbits);
+  free_noise(noise);
+  return 0;
+}
@@ -24,6 +24,8 @@ struct option Options[] = {
   {"force-mmx",0,NULL,'m'},
   {"force-sse",0,NULL,'s'},
   {"force-sse2",0,NULL,'t'},
+  {"stream-depth",1,NULL,'d'},
+  {"symbol-bits",1,NULL,'q'},
   {NULL},
 };
 #endif
@@ -35,16 +37,22 @@ struct option Options[] = {
 
 double Gain = 24.0;
 int Verbose = 0;
+int Depth = 0; /* Traceback depth for the streaming decoder, 0 = block decoder */
+int Symbits = 0; /* Pack symbols to this many bits for the decoder, 0 = don't */
+
+int streamtest(int trials,int framebits,double ebn0);
 
 int main(int argc,char *argv[]){
   int i,d,tr;
-  int sr=0,trials = 10,errcnt,framebits=2048;
+  int trials = 10,errcnt,framebits=2048;
   int tot_errs=0;
-  unsigned char bits[MAXBYTES];
+  unsigned char bits[MAXBYTES+2];
   unsigned char data[MAXBYTES];
   unsigned char xordata[MAXBYTES];
   unsigned char symbols[8*6*(MAXBYTES+14)];
-  void *vp;
+  unsigned char packed[8*6*(MAXBYTES+14)];
+  void *vp,*enc;
+  void *noise;
   extern char *optarg;
   struct tms start,finish;
   double extime;
@@ -57,9 +65,9 @@ int main(int argc,char *argv[]){
   srandom(t);
   ebn0 = -100;
 #if HAVE_GETOPT_LONG
-  while((d = getopt_long(argc,argv,"l:n:te:g:vapmst",Options,NULL)) != EOF){
+  while((d = getopt_long(argc,argv,"l:n:te:g:vapmstd:q:",Options,NULL)) != EOF){
 #else
-  while((d = getopt(argc,argv,"l:n:te:g:vapmst")) != EOF){
+  while((d = getopt(argc,argv,"l:n:te:g:vapmstd:q:")) != EOF){
 #endif
     switch(d){
     case 'a':
@@ -92,12 +100,20 @@ int main(int argc,char *argv[]){
     case 'v':
       Verbose++;
       break;
+    case 'd':
+      Depth = atoi(optarg);
+      break;
+    case 'q':
+      Symbits = atoi(optarg);
+      break;
     }
   }
   if(framebits > 8*MAXBYTES){
     fprintf(stderr,"Frame limited to %d bits\n",MAXBYTES*8);
     framebits = MAXBYTES*8;
   }
+  if(Depth > 0)
+    exit(streamtest(trials,framebits,ebn0));
   if((vp = create_viterbi615(framebits)) == NULL){
     printf("create_viterbi615 failed\n");
     exit(1);
@@ -109,29 +125,33 @@ int main(int argc,char *argv[]){
      * voltage.
      */
     gain = 1./sqrt(0.5/pow(10.,esn0/10.));
+    noise = init_noise(gain,Gain,OFFSET,CLIP,random());
+    if((enc = create_encoder615()) == NULL){
+      printf("create_encoder615 failed\n");
+      exit(1);
+    }
     
     printf("nframes = %d framesize = %d ebn0 = %.2f dB gain = %g\n",trials,framebits,ebn0,Gain);
     
     for(tr=0;tr<trials;tr++){
-      /* Encode a frame of random data */
-      for(i=0;i<framebits+14;i++){
-	int bit = (i < framebits) ? (random() & 1) : 0;
-	
-	sr = (sr << 1) | bit;
-	bits[i/8] = sr & 0xff;
-	symbols[6*i+0] = addnoise(parity(sr & V615POLYA),gain,Gain,OFFSET,CLIP);
-	symbols[6*i+1] = addnoise(parity(sr & V615POLYB),gain,Gain,OFFSET,CLIP);
-	symbols[6*i+2] = addnoise(parity(sr & V615POLYC),gain,Gain,OFFSET,CLIP);
-	symbols[6*i+3] = addnoise(parity(sr & V615POLYD),gain,Gain,OFFSET,CLIP);
-	symbols[6*i+4] = addnoise(parity(sr & V615POLYE),gain,Gain,OFFSET,CLIP);
-	symbols[6*i+5] = addnoise(parity(sr & V615POLYF),gain,Gain,OFFSET,CLIP);
-      }
+      /* Encode a frame of random data, with zeros after it for the tail */
+      memset(bits,0,(framebits+14+7)/8);
+      for(i=0;i<framebits/8;i++)
+	bits[i] = random() & 0xff;
+      init_encoder(enc,0);
+      encode_conv(enc,symbols,bits,(framebits+14+7)/8);
+      addnoise_blk(noise,symbols,symbols,6*(framebits+14));
       /* Decode it and make sure we get the right answer */
       /* Initialize Viterbi decoder */
       init_viterbi615(vp,0);
       
       /* Decode block */
-      metrics += update_viterbi615_blk(vp,symbols,framebits+14);
+      if(Symbits != 0){
+	/* Pass them packed, as from a hard decision or coarse soft decision demod */
+	pack_syms(packed,symbols,6*(framebits+14),Symbits);
+	metrics += update_viterbi615_blk_packed(vp,packed,framebits+14,Symbits);
+      } else
+	metrics += update_viterbi615_blk(vp,symbols,framebits+14);
       
       /* Do Viterbi chainback */
       metrics += chainback_viterbi615(vp,data,framebits,0);
@@ -168,6 +188,7 @@ int main(int argc,char *argv[]){
 	       (double)metrics/(tr+1));
     else
       printf("\n");
+    free_noise(noise);
   } else {
     /* Do time trials */
     memset(symbols,127,sizeof(symbols));
@@ -191,3 +212,72 @@ int main(int argc,char *argv[]){
   }
   exit(0);
 }
+
+/* Decode trials*framebits bits as one continuous stream, framebits at a time,
+ * with the streaming decoder. Only the very end of the stream has a tail
+ */
+int streamtest(int trials,int framebits,double ebn0){
+  long long i,nbits,out = 0,tot_errs = 0;
+  int tr,n,sr = 0;
+  unsigned char *bits,*data,*symbols;
+  void *vp;
+  void *noise;
+  struct tms start,finish;
+  double extime,gain = 0,esn0;
+
+  nbits = (long long)trials * framebits;
+  bits = calloc(nbits/8 + 2,1);
+  data = calloc(nbits/8 + Depth/4 + 2,1);
+  symbols = malloc(6*(framebits+14));
+  if((vp = create_viterbi615_stream(Depth)) == NULL){
+    printf("create_viterbi615_stream failed\n");
+    return 1;
+  }
+  if(ebn0 == -100){
+    /* Do time trials */
+    memset(symbols,127,6*(framebits+14));
+    printf("Starting time trials, traceback depth %d\n",Depth);
+    init_viterbi615_stream(vp,0);
+    times(&start);
+    for(tr=0;tr < trials;tr++)
+      out += update_viterbi615_stream(vp,symbols,framebits,data);
+    times(&finish);
+    extime = ((double)(finish.tms_utime-start.tms_utime))/CLOCKS_PER_SEC;
+    printf("Execution time for %lld bits: %.2f sec\n",nbits,extime);
+    printf("decoder speed: %g bits/s\n",nbits/extime);
+    return 0;
+  }
+  esn0 = ebn0 + 10*log10((double)RATE); /* Es/No in dB */
+  gain = 1./sqrt(0.5/pow(10.,esn0/10.));
+  noise = init_noise(gain,Gain,OFFSET,CLIP,random());
+  printf("nbits = %lld ebn0 = %.2f dB gain = %g traceback depth = %d\n",nbits,ebn0,Gain,Depth);
+
+  init_viterbi615_stream(vp,0);
+  for(tr=0;tr<trials;tr++){
+    /* Encode the next framebits of the stream; the last piece gets the tail */
+    n = framebits + (tr == trials-1 ? 14 : 0);
+    for(i=0;i<n;i++){
+      int bit = (i < framebits) ? (random() & 1) : 0;
+
+      sr = (sr << 1) | bit;
+      if(i < framebits)
+	bits[((long long)tr*framebits+i)/8] = sr & 0xff;
+      symbols[6*i+0] = parity(sr & V615POLYA);
+      symbols[6*i+1] = parity(sr & V615POLYB);
+      symbols[6*i+2] = parity(sr & V615POLYC);
+      symbols[6*i+3] = parity(sr & V615POLYD);
+      symbols[6*i+4] = parity(sr & V615POLYE);
+      symbols[6*i+5] = parity(sr & V615POLYF);
+    }
+    addnoise_blk(noise,symbols,symbols,6*n);
+    out += update_viterbi615_stream(vp,symbols,n,data+out/8);
+  }
+  out += flush_viterbi615_stream(vp,data+out/8,0);
+  if(out != nbits)
+    printf("released %lld bits, expected %lld\n",out,nbits);
+  for(i=0;i<nbits/8;i++)
+    tot_errs += Bitcnt[data[i] ^ bits[i]];
+  printf("BER %lld/%lld (%.3g)\n",tot_errs,nbits,tot_errs/(double)nbits);
+  free_noise(noise);
+  return 0;
+}